@@ -44,4 +44,18 @@ int bit_clear(int value, int bit);
  */
 int bit_toggle(int value, int bit);
 
+/**
+ * Finds the first (least significant) bit that is set
+ * @param value - the integer value to scan
+ * @return index of the first bit set, -1 if no bits are set
+ */
+int bit_first_set(unsigned int value);
+
+/**
+ * Finds the last (most significant) bit that is set
+ * @param value - the integer value to scan
+ * @return index of the last bit set, -1 if no bits are set
+ */
+int bit_last_set(unsigned int value);
+
 #endif
@@ -0,0 +1,65 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Id Tables
+ */
+#ifndef IDTABLE_H
+#define IDTABLE_H
+
+// Id table entry
+typedef struct idtable_entry_t {
+    void *object;                   // Object the id is bound to, NULL if the id is free
+    int next_free;                  // Next free id while the id is free, -1 at the end
+} idtable_entry_t;
+
+// Table binding small integer ids to objects
+// The table grows on demand up to its maximum, and shrinks back when most
+// of its ids are free
+typedef struct idtable_t {
+    idtable_entry_t *entries;       // Table entries, NULL until the first id is allocated
+    int size;                       // Number of entries
+    int used;                       // Number of ids bound to objects
+    int upper_used;                 // Number of ids in the upper half of the table bound to objects
+    int free_head;                  // First free id, -1 if none
+    int init_size;                  // Number of entries the table starts with
+    int max_size;                   // Number of entries the table may grow to
+} idtable_t;
+
+/**
+ * Initializes an empty id table
+ * @param table - pointer to the id table
+ * @param init_size - number of entries the table starts with
+ * @param max_size - number of entries the table may grow to
+ */
+void idtable_init(idtable_t *table, int init_size, int max_size);
+
+/**
+ * Binds an object to a free id
+ * The lowest free ids of a new table are used first; the table doubles
+ * in size when no id is free
+ * @param table - pointer to the id table
+ * @param object - object to bind; must not be NULL
+ * @return the id, -1 if no id is available
+ */
+int idtable_alloc(idtable_t *table, void *object);
+
+/**
+ * Frees an id
+ * The table halves in size once only a quarter of its ids are in use and
+ * none of them are in its upper half
+ * @param table - pointer to the id table
+ * @param id - the id to free
+ * @return 0 on success, -1 if the id is not in use
+ */
+int idtable_free(idtable_t *table, int id);
+
+/**
+ * Looks up the object bound to an id
+ * @param table - pointer to the id table
+ * @param id - the id
+ * @return pointer to the object, NULL if the id is not in use
+ */
+void *idtable_get(idtable_t *table, int id);
+#endif
@@ -11,6 +11,8 @@
 #include <spede/machine/asmacros.h>
 
 // IRQ Definitions
+#define IRQ_FPU      0x07       // CPU exception 7 (Device not available)
+#define IRQ_PAGE_FAULT 0x0e     // CPU exception 14 (Page fault)
 #define IRQ_TIMER    0x20       // PIC IRQ 0 (Timer)
 #define IRQ_KEYBOARD 0x21       // PIC IRQ 1 (Keyboard)
 #define IRQ_SYSCALL  0x80       // System call IRQ
@@ -46,6 +48,16 @@ void interrupts_irq_register(int irq, void (*entry)(), void (*handler)());
  */
 void interrupts_irq_handler(int irq);
 
+/**
+ * Registers a task gate for the specified interrupt
+ * The interrupt switches to the task described by the TSS, which runs on
+ * its own stack; used for faults that can not be handled on the
+ * interrupted stack
+ * @param irq - interrupt number
+ * @param selector - GDT selector of the task's TSS
+ */
+void interrupts_task_register(int irq, int selector);
+
 /**
  * Enables the specified IRQ in the PIC
  * @param irq - IRQ number
@@ -77,6 +89,7 @@ __BEGIN_DECLS
 extern void isr_entry_timer();
 extern void isr_entry_keyboard();
 extern void isr_entry_syscall();
+extern void isr_entry_fpu();
 
 __END_DECLS
 #endif
@@ -129,6 +129,8 @@ void kernel_context_enter(trapframe_t *trapframe);
 __BEGIN_DECLS
 /**
  * Exits the kernel context and restores the process context
+ * Takes the process' trapframe and page directory (NULL to keep the
+ * current address space)
  */
 extern void kernel_context_exit();
 __END_DECLS
@@ -0,0 +1,44 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel FPU/SSE Context Handling
+ */
+#ifndef KFPU_H
+#define KFPU_H
+
+#include "kproc.h"
+
+// Size of the saved FPU/SSE state (FXSAVE area)
+#define KFPU_STATE_SIZE 512
+
+/**
+ * Initializes the FPU and registers the device-not-available handler
+ * The FPU starts out unowned; the first process to use it takes it over
+ */
+void kfpu_init(void);
+
+/**
+ * Prepares the FPU for a process about to run
+ * The FPU is left usable only if the process owns the loaded state; any
+ * other process traps on its first FPU instruction and the state is
+ * switched then
+ * @param proc - process about to run
+ */
+void kfpu_switch(proc_t *proc);
+
+/**
+ * Gives a forked process a copy of its parent's FPU state
+ * @param parent - process that was forked
+ * @param child - copy of the process
+ * @return 0 on success, -1 if no memory is available
+ */
+int kfpu_fork(proc_t *parent, proc_t *child);
+
+/**
+ * Releases a process' FPU state
+ * @param proc - process being destroyed
+ */
+void kfpu_release(proc_t *proc);
+#endif
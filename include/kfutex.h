@@ -0,0 +1,79 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Futexes
+ */
+#ifndef KFUTEX_H
+#define KFUTEX_H
+
+#include "kproc.h"
+
+// Number of wait queues futex waiters are hashed into
+#ifndef KFUTEX_BUCKETS
+#define KFUTEX_BUCKETS 16
+#endif
+
+/**
+ * Initializes the futex wait queues
+ */
+void kfutex_init(void);
+
+/**
+ * Blocks a process until the futex is woken, if the futex word still
+ * holds the expected value
+ * @param proc - process to block
+ * @param addr - address of the futex word in the process
+ * @param val - value the caller last saw in the futex word
+ * @return 0 if the process was blocked, -1 if the value changed or on error
+ */
+int kfutex_wait(proc_t *proc, int *addr, int val);
+
+/**
+ * Wakes processes waiting on a futex
+ * @param proc - process waking the futex
+ * @param addr - address of the futex word in the process
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int kfutex_wake(proc_t *proc, int *addr, int count);
+
+/**
+ * Locks a priority inheritance futex
+ * The futex word holds the owner's process id. If another process owns the
+ * futex, the process blocks and the owner runs at the process' priority
+ * until the futex is passed on
+ * @param proc - process locking the futex
+ * @param addr - address of the futex word in the process
+ * @return 0 once the process owns the futex, -1 on error
+ */
+int kfutex_lock(proc_t *proc, int *addr);
+
+/**
+ * Unlocks a priority inheritance futex
+ * The futex is passed to the highest priority process waiting on it, and
+ * the previous owner's effective priority drops back to what the locks it
+ * still holds require
+ * @param proc - process unlocking the futex
+ * @param addr - address of the futex word in the process
+ * @return 0 on success, -1 if the process does not own the futex or on error
+ */
+int kfutex_unlock(proc_t *proc, int *addr);
+
+/**
+ * Returns the highest priority process waiting on a priority inheritance
+ * futex owned by a process
+ * @param owner - pointer to the owner
+ * @return pointer to the process, NULL if no process is waiting
+ */
+proc_t *kfutex_waiter_top(proc_t *owner);
+
+/**
+ * Releases the futexes of a process that is exiting
+ * The process stops waiting on a futex, and each priority inheritance
+ * futex it owns is passed to the highest priority process waiting on it
+ * @param proc - pointer to the process
+ */
+void kfutex_release(proc_t *proc);
+#endif
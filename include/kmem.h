@@ -0,0 +1,89 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Memory - Buddy Page Allocator
+ */
+#ifndef KMEM_H
+#define KMEM_H
+
+#include "list.h"
+
+#define KMEM_PAGE_SHIFT     12
+#define KMEM_PAGE_SIZE      (1 << KMEM_PAGE_SHIFT)
+
+// Number of bytes of memory above the kernel image that is managed
+#ifndef KMEM_SIZE
+#define KMEM_SIZE           (32 * 1024 * 1024)
+#endif
+
+#define KMEM_PAGES          (KMEM_SIZE / KMEM_PAGE_SIZE)
+
+// Number of block orders; the largest block is 2^(KMEM_ORDER_MAX-1) pages
+#define KMEM_ORDER_MAX      11
+
+// Page descriptor; one for each managed page
+// Describes the block or slab that starts at the page
+typedef struct kmem_page_t {
+    list_node_t node;               // Links the block into a free list or its slab into a cache
+    int order;                      // Order of the block that starts at this page
+    int free;                       // Set if the block is free
+    struct kmem_cache_t *cache;     // Cache the slab belongs to, NULL if not a slab
+    void *objects;                  // Free objects in the slab
+    int in_use;                     // Number of objects allocated from the slab
+    int shares;                     // Number of other address spaces the page is mapped in
+} kmem_page_t;
+
+/**
+ * Initializes the page allocator with the memory above the kernel image
+ */
+void kmem_init(void);
+
+/**
+ * Allocates a block of pages
+ * @param order - the block is 2^order pages
+ * @return pointer to the block, NULL if no block is available
+ */
+void *kmem_page_alloc(int order);
+
+/**
+ * Frees a block of pages
+ * @param addr - pointer to the block
+ */
+void kmem_page_free(void *addr);
+
+/**
+ * Looks up the descriptor of the page containing an address
+ * @param addr - address within the managed memory
+ * @return pointer to the page descriptor, NULL if not managed memory
+ */
+kmem_page_t *kmem_addr_to_page(void *addr);
+
+/**
+ * Returns the address of a page
+ * @param page - pointer to the page descriptor
+ * @return pointer to the start of the page
+ */
+void *kmem_page_to_addr(kmem_page_t *page);
+
+/**
+ * Returns the index of a page within the managed memory
+ * @param page - pointer to the page descriptor
+ * @return page index
+ */
+int kmem_page_index(kmem_page_t *page);
+
+/**
+ * Returns the end of the managed memory
+ * @return address of the first byte above the managed memory
+ */
+void *kmem_limit(void);
+
+/**
+ * Returns the number of pages that are free
+ * @return number of free pages
+ */
+int kmem_pages_free(void);
+
+#endif
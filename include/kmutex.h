@@ -9,18 +9,25 @@
 #define KMUTEX_H
 
 #include "kproc.h"
-#include "queue.h"
+#include "list.h"
 
 // Maximum number of mutexes supported
+// The mutex table starts with MUTEX_TABLE_INIT ids, doubles when it fills
+// up and halves when it is mostly unused
 #ifndef MUTEX_MAX
-#define MUTEX_MAX 16
+#define MUTEX_MAX 2048
+#endif
+
+#ifndef MUTEX_TABLE_INIT
+#define MUTEX_TABLE_INIT 16
 #endif
 
 typedef struct mutex_t {
     int allocated;          // Indicates that this mutex has been allocated
     int locks;              // The current number of locks held
     proc_t *owner;          // The process that currently holds the mutex
-    queue_t wait_queue;     // The processes waiting on the mutex
+    list_node_t owner_node; // Links the mutex into its owner's list of held mutexes
+    list_t wait_queue;      // The processes waiting on the mutex
 } mutex_t;
 
 /**
@@ -44,6 +51,8 @@ int kmutex_destroy(int id);
 
 /**
  * Locks the specified mutex
+ * A process that has to wait raises the owner's effective priority to its
+ * own, and that of the owner of any mutex the owner is waiting on
  * @param id - the mutex id
  * @return -1 on error, otherwise the current lock count
  */
@@ -51,8 +60,44 @@ int kmutex_lock(int id);
 
 /**
  * Unlocks the specified mutex
+ * The highest priority waiter takes the mutex, and the previous owner's
+ * effective priority drops back to what the mutexes it still holds require
  * @param id - the mutex id
  * @return -1 on error, otherwise the current lock count
  */
 int kmutex_unlock(int id);
+
+/**
+ * Releases the mutexes of a process that is exiting
+ * The process stops waiting on a mutex, and each mutex it owns is passed
+ * to the highest priority process waiting on it
+ * @param proc - pointer to the process
+ */
+void kmutex_release(proc_t *proc);
+
+/**
+ * Returns the effective priority a process should run at
+ * A process runs at the priority of the highest priority process waiting
+ * on a kernel mutex or priority inheritance futex it owns, if that is
+ * higher than its own
+ * @param proc - pointer to the process
+ * @return priority level
+ */
+int kmutex_priority(proc_t *proc);
+
+/**
+ * Raises the effective priority of a lock owner to a waiter's priority
+ * If the owner is itself waiting on a kernel mutex or priority inheritance
+ * futex, the priority is passed along the chain of owners
+ * @param owner - pointer to the owner of the lock being waited on
+ * @param priority - priority of the waiter
+ */
+void kmutex_inherit(proc_t *owner, int priority);
+
+/**
+ * Recomputes the effective priority of a lock owner after a waiter left
+ * The change is passed along the chain of owners
+ * @param owner - pointer to the owner of the lock the waiter left
+ */
+void kmutex_update(proc_t *owner);
 #endif
@@ -0,0 +1,57 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Pipes
+ */
+#ifndef KPIPE_H
+#define KPIPE_H
+
+#include "kproc.h"
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of a process
+ * Reading from the read end blocks while the pipe is empty and returns 0
+ * once it is empty with no write ends left; writing to the write end
+ * blocks while the pipe is full and fails with no read ends left
+ * @param proc - process creating the pipe
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return 0 on success, -1 on error
+ */
+int kpipe_create(proc_t *proc, int *ends, int size);
+
+/**
+ * Closes an IO slot of a process
+ * A pipe is released when its last end is closed
+ * @param proc - process closing the slot
+ * @param io - the IO id
+ * @return 0 on success, -1 on error
+ */
+int kpipe_close(proc_t *proc, int io);
+
+/**
+ * Binds a process' IO buffer into the same IO slot of another process
+ * A pipe end takes a reference on the pipe
+ * @param parent - process holding the IO buffer
+ * @param child - process receiving the IO buffer
+ * @param io - the IO id
+ */
+void kpipe_dup(proc_t *parent, proc_t *child, int io);
+
+/**
+ * Passes the pipe ends of a process to another process
+ * The ends are bound to the same IO ids in the other process
+ * @param parent - process holding the pipe ends
+ * @param child - process receiving the pipe ends
+ */
+void kpipe_fork(proc_t *parent, proc_t *child);
+
+/**
+ * Closes all of the pipe ends a process holds
+ * @param proc - process to release
+ */
+void kpipe_release(proc_t *proc);
+
+#endif
@@ -10,15 +10,46 @@
 
 #include "trapframe.h"
 #include "ringbuf.h"
-#include "queue.h"
+#include "list.h"
+#include "rbtree.h"
+#include "syscall_common.h"
 
 #ifndef PROC_MAX
-#define PROC_MAX        20   // maximum number of processes to support
+#define PROC_MAX        2048 // maximum number of processes to support
 #endif
 
+// Number of process table entries allocated at startup
+// The table doubles in size each time it fills up, up to PROC_MAX
+#ifndef PROC_TABLE_INIT
+#define PROC_TABLE_INIT 32
+#endif
+
+// Process ids encode the process table entry in the low bits and a
+// generation count (incremented each time the entry is reused) above it
+#define PROC_PID_ENTRY_BITS 12
+#define PROC_PID_ENTRY_MASK ((1 << PROC_PID_ENTRY_BITS) - 1)
+#define PROC_PID_GEN_MASK   ((1 << (31 - PROC_PID_ENTRY_BITS)) - 1)
+
+#if PROC_MAX > (1 << PROC_PID_ENTRY_BITS)
+#error "PROC_MAX exceeds the number of entries a process id can encode"
+#endif
+
+// Number of pre-built process templates kept ready for process creation,
+// and the number of ticks between refills of the pool
+#ifndef PROC_POOL_SIZE
+#define PROC_POOL_SIZE  8
+#endif
+
+#define PROC_POOL_REFILL_INTERVAL 10
+
 #define PROC_IO_MAX     4    // Maximum process I/O buffers
 
+// Pipe end bound to a process I/O slot
+#define PROC_PIPE_READ  1    // Read end
+#define PROC_PIPE_WRITE 2    // Write end
+
 #define PROC_NAME_LEN   32   // Maximum length of a process name
+#define PROC_CACHE_LINE 64   // Alignment of the process control block
 #define PROC_STACK_SIZE 8192 // Process stack size
 
 // Process types
@@ -39,27 +70,66 @@ typedef enum state_t {
 } state_t;
 
 
+struct scheduler_class_t;
+struct mutex_t;
+
 // Process control block
 // Contains all details to describe a process
+// The fields read on every tick and by scans of all processes come first
+// and fill one cache line; the control block is cache line aligned so a
+// scan touches a single line per process. Metadata that is only used when
+// the process runs or is inspected follows.
 typedef struct proc_t {
+    // Hot -> scheduling state
     int pid;                        // Process id
     state_t state;                  // Process state
-    proc_type_t type;               // Process type (kernel or user)
-
-    char name[PROC_NAME_LEN];       // Process name
-
-    int start_time;                 // Time started
+    int priority;                   // Effective scheduling priority (0 is the highest)
+    int on_run_queue;               // Set while the process is ready to run and queued
     int run_time;                   // Total run time of the process
     int cpu_time;                   // Current CPU time the process has used
-    int sleep_time;                 // Time that a process should be sleeping
-
-    queue_t *scheduler_queue;       // Pointer to the queue where the process resides
+    int wake_time;                  // Timer tick when a sleeping process wakes up
+    int sleep_index;                // Position of the process in the sleep queue
+    struct scheduler_class_t *sched_class; // Scheduling class; NULL for the best-effort class
+    list_t *scheduler_queue;        // Pointer to the queue where the process resides
+    list_node_t scheduler_node;     // Links the process into its scheduler queue
+    list_node_t proc_node;          // Links the process into the list of all processes
+    unsigned int vruntime;          // Weighted virtual run time (fair scheduler)
+    int feedback_level;             // Feedback level below the priority (0 is the most interactive)
+
+    // Warm -> scheduling policy details and statistics
+    int boost_epoch;                // Anti-starvation boost the feedback level was last reset at
+    rbtree_node_t run_node;         // Orders the process in a run tree (fair or deadline)
+    int switches_voluntary;         // Number of times the process gave up the CPU
+    int switches_involuntary;       // Number of times the process was preempted
+
+    int period;                     // Ticks between job releases; 0 if not periodic
+    int budget;                     // Ticks of CPU time each job may use
+    int budget_used;                // Ticks of CPU time used by the current job
+    int release_time;               // Tick the current job was released at
+    int deadline;                   // Tick the current job must complete by
+    int deadline_misses;            // Number of jobs completed after their deadline
+    int budget_overruns;            // Number of jobs stopped for exceeding their budget
+
+    unsigned int futex_key;         // Futex the process is waiting on
+    int futex_owner;                // Owner of the priority inheritance futex the process is waiting on, 0 if none
+    int base_priority;              // Priority set for the process; mutex waiters may raise priority above it
+    struct mutex_t *mutex_wait;     // Mutex the process is waiting on
+    list_t mutexes_held;            // Kernel mutexes the process owns
+
+    // Cold -> process metadata and resources
+    proc_type_t type;               // Process type (kernel or user)
+    int start_time;                 // Time started
+    char name[PROC_NAME_LEN];       // Process name
 
     ringbuf_t *io[PROC_IO_MAX];     // Process input/output buffers
+    unsigned char io_pipe[PROC_IO_MAX]; // Pipe end bound to each I/O slot, 0 if not a pipe
+    unsigned int shm_attached;      // Shared memory regions the process is attached to (bit per id)
 
+    unsigned char *fpu_state;       // Saved FPU/SSE state, NULL until the process uses the FPU
+    unsigned int *page_dir;         // Page directory of the process' address space, NULL without paging
     unsigned char *stack;           // Pointer to the process stack
     trapframe_t *trapframe;         // Pointer to the trapframe
-} proc_t;
+} __attribute__((aligned(PROC_CACHE_LINE))) proc_t;
 
 
 /**
@@ -105,6 +175,44 @@ proc_t *pid_to_proc(int pid);
  */
 proc_t *entry_to_proc(int entry);
 
+/**
+ * Returns the first process in the list of all processes
+ * Processes are listed in the order they were created
+ * @return pointer to the process entry, NULL if there are no processes
+ */
+proc_t *proc_list_first(void);
+
+/**
+ * Returns the process after the given one in the list of all processes
+ * @param proc - pointer to the process entry
+ * @return pointer to the process entry, NULL at the end of the list
+ */
+proc_t *proc_list_next(proc_t *proc);
+
+/**
+ * Returns the number of processes
+ * @return number of processes
+ */
+int proc_count(void);
+
+/**
+ * Creates a copy of a process
+ * The copy shares the parent's pages copy-on-write, its I/O buffers and
+ * its priority, and resumes from the same point with 0 as the result of
+ * the system call
+ * Only the pages the process' address space owns (its stack) are copied;
+ * globals live in the kernel image, which every address space maps, so
+ * the copy shares them with the parent and sees the parent's writes
+ * @param parent - process to copy; must be making a system call
+ * @return process id of the copy, -1 on error
+ */
+int kproc_fork(proc_t *parent);
+
+/**
+ * Prints the process creation statistics to the kernel log
+ */
+void kproc_dump(void);
+
 /**
  * Test process
  */
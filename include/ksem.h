@@ -9,17 +9,23 @@
 #define KSEM_H
 
 #include "kproc.h"
-#include "queue.h"
+#include "list.h"
 
 // Maximum number of semaphores supported
+// The semaphore table starts with SEM_TABLE_INIT ids, doubles when it
+// fills up and halves when it is mostly unused
 #ifndef SEM_MAX
-#define SEM_MAX 16
+#define SEM_MAX 2048
+#endif
+
+#ifndef SEM_TABLE_INIT
+#define SEM_TABLE_INIT 16
 #endif
 
 typedef struct sem_t {
     int allocated;          // Indicates that this semaphore has been allocated
     int count;              // The current semaphore count
-    queue_t wait_queue;     // The processes waiting on the semaphore
+    list_t wait_queue;      // The processes waiting on the semaphore
 } sem_t;
 
 /**
@@ -0,0 +1,73 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Shared Memory
+ */
+#ifndef KSHM_H
+#define KSHM_H
+
+#include "kproc.h"
+
+// Maximum number of shared memory regions supported
+#ifndef SHM_MAX
+#define SHM_MAX 16
+#endif
+
+// Maximum size of a shared memory region
+#ifndef SHM_SIZE_MAX
+#define SHM_SIZE_MAX (64 * 4096)
+#endif
+
+// Shared memory regions are mapped at the same address in every process;
+// each region id has its own SHM_SIZE_MAX window above SHM_BASE
+#define SHM_BASE 0x80000000
+
+typedef struct shm_t {
+    int size;               // Size of the region in bytes
+    int order;              // The region's pages are one block of 2^order pages
+    unsigned char *mem;     // Physical address of the region's pages
+    int attached;           // Number of processes attached to the region
+} shm_t;
+
+/**
+ * Creates a shared memory region and attaches the process to it
+ * The region starts out clear
+ * @param proc - process creating the region
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id that was allocated
+ */
+int kshm_create(proc_t *proc, int size);
+
+/**
+ * Attaches a process to a shared memory region
+ * @param proc - process to attach
+ * @param id - the shared memory identifier
+ * @return address of the region in the process, NULL on error
+ */
+void *kshm_attach(proc_t *proc, int id);
+
+/**
+ * Detaches a process from a shared memory region
+ * The region is released when the last process detaches from it
+ * @param proc - process to detach
+ * @param id - the shared memory identifier
+ * @return 0 on success, -1 on error
+ */
+int kshm_detach(proc_t *proc, int id);
+
+/**
+ * Attaches a forked process to its parent's shared memory regions
+ * The regions are already mapped in the copied address space
+ * @param parent - process that was forked
+ * @param child - copy of the process
+ */
+void kshm_fork(proc_t *parent, proc_t *child);
+
+/**
+ * Detaches a process from all of its shared memory regions
+ * @param proc - process to detach
+ */
+void kshm_release(proc_t *proc);
+#endif
@@ -0,0 +1,89 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Memory - Slab Caches
+ */
+#ifndef KSLAB_H
+#define KSLAB_H
+
+#include "kmem.h"
+#include "list.h"
+
+// Cache flags
+#define KMEM_CACHE_ZERO     0x01    // Objects are handed out clear; they must be freed clear
+
+// Interval, in ticks, at which cache statistics are sampled and idle caches shrink
+#ifndef KMEM_CACHE_REAP_INTERVAL
+#define KMEM_CACHE_REAP_INTERVAL 100
+#endif
+
+// Cache of equally sized objects, carved out of slabs of 2^order pages
+typedef struct kmem_cache_t {
+    char *name;                 // Cache name
+    int size;                   // Object size in bytes
+    int order;                  // Order of the page blocks slabs are made of
+    int flags;                  // Cache flags
+
+    int capacity;               // Number of objects per slab
+    int registered;             // Set once the cache has been set up
+
+    list_t slabs_partial;       // Slabs with free and allocated objects
+    list_t slabs_full;          // Slabs with only allocated objects
+    list_t slabs_empty;         // Slabs with only free objects
+
+    int slabs;                  // Number of slabs
+    int in_use;                 // Number of objects allocated
+    int free;                   // Number of free objects in the slabs
+    int allocs;                 // Total number of allocations
+    int allocs_sampled;         // Total number of allocations when last sampled
+    int alloc_rate;             // Allocations during the last sample interval
+
+    list_node_t node;           // Links the cache into the list of caches
+} kmem_cache_t;
+
+/**
+ * Static initializer for a cache
+ * The cache is set up when the first object is allocated
+ * @param cache_name - cache name
+ * @param object_size - object size in bytes
+ * @param cache_order - order of the page blocks slabs are made of
+ * @param cache_flags - cache flags
+ */
+#define KMEM_CACHE(cache_name, object_size, cache_order, cache_flags) \
+    { .name = (cache_name), .size = (object_size), .order = (cache_order), .flags = (cache_flags) }
+
+/**
+ * Allocates an object from a cache
+ * @param cache - pointer to the cache
+ * @return pointer to the object, NULL if no memory is available
+ */
+void *kmem_cache_alloc(kmem_cache_t *cache);
+
+/**
+ * Returns an object to its cache
+ * @param cache - pointer to the cache
+ * @param obj - pointer to the object
+ */
+void kmem_cache_free(kmem_cache_t *cache, void *obj);
+
+/**
+ * Releases the empty slabs of a cache
+ * @param cache - pointer to the cache
+ * @return number of pages released
+ */
+int kmem_cache_shrink(kmem_cache_t *cache);
+
+/**
+ * Prints the statistics of every cache to the kernel log
+ */
+void kmem_cache_dump(void);
+
+/**
+ * Initializes the slab caches
+ * Registers the timer that samples statistics and shrinks idle caches
+ */
+void kmem_caches_init(void);
+
+#endif
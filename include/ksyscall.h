@@ -10,6 +10,10 @@
 
 #include "syscall_common.h"
 
+// Returned by a system call handler that blocked the process; the system
+// call is executed again when the process is woken up
+#define KSYSCALL_RESTART    (-2)
+
 /**
  * System Call Initialization
  */
@@ -17,19 +21,26 @@ void ksyscall_init(void);
 
 /**
  * Writes up to n bytes to the process' specified IO buffer
- * @param io - the IO buffer to write to
+ * Copies as many bytes as fit, blocking until there is space unless
+ * PROC_IO_NONBLOCK is set in io
+ * @param io - the IO buffer to write to, optionally with PROC_IO_NONBLOCK
  * @param buf - the buffer to copy from
  * @param n - number of bytes to write
- * @return -1 on error or value indicating number of bytes copied
+ * @return -1 on error, KSYSCALL_RESTART if the process blocked, or value
+ *         indicating number of bytes copied
  */
 int ksyscall_io_write(int io, char *buf, int n);
 
 /**
  * Reads up to n bytes from the process' specified IO buffer
- * @param io - the IO buffer to read from
+ * Blocks until data is available unless PROC_IO_NONBLOCK is set in io;
+ * returns 0 at the end of a pipe
+ * @param io - the IO buffer to read from, optionally with PROC_IO_NONBLOCK
+ *             (PROC_IO_SHORT is accepted; reads never wait for all n bytes)
  * @param buf - the buffer to copy to
  * @param n - number of bytes to read
- * @return -1 on error or value indicating number of bytes copied
+ * @return -1 on error, KSYSCALL_RESTART if the process blocked, or value
+ *         indicating number of bytes copied
  */
 int ksyscall_io_read(int io, char *buf, int n);
 
@@ -59,6 +70,12 @@ int ksyscall_sys_get_name(char *name);
  */
 int ksyscall_proc_sleep(int seconds);
 
+/**
+ * Yields the CPU to other processes that are ready to run
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_yield(void);
+
 /**
  * Exits the current process
  */
@@ -77,6 +94,45 @@ int ksyscall_proc_get_pid(void);
  */
 int ksyscall_proc_get_name(char *name);
 
+/**
+ * Sets the current process' scheduling priority
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_set_priority(int priority);
+
+/**
+ * Gets the current process' scheduling priority
+ * @return priority level or -1 on error
+ */
+int ksyscall_proc_get_priority(void);
+
+/**
+ * Makes the active process periodic; each job must complete (by yielding)
+ * within its budget before the end of its period
+ * @param period - number of ticks between job releases, 0 to clear
+ * @param budget - number of ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int ksyscall_proc_set_periodic(int period, int budget);
+
+/**
+ * Creates a new process
+ * @param entry - function the process starts executing
+ * @param name - process name
+ * @param flags - PROC_SPAWN_TTY to attach the process to the active process' TTY,
+ *                PROC_SPAWN_PIPES to pass it the active process' pipe ends
+ * @return process id of the new process, -1 on error
+ */
+int ksyscall_proc_spawn(void *entry, char *name, int flags);
+
+/**
+ * Creates a copy of the active process
+ * The copy shares the active process' pages until either one writes to them
+ * @return process id of the copy, -1 on error
+ */
+int ksyscall_proc_fork(void);
+
 /**
  * Allocates a mutex from the kernel
  * @return -1 on error, all other values indicate the mutex id
@@ -132,6 +188,76 @@ int ksyscall_sem_wait(int sem);
  */
 int ksyscall_sem_post(int sem);
 
+/**
+ * Creates a shared memory region and attaches the active process to it
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id
+ */
+int ksyscall_shm_create(int size);
+
+/**
+ * Attaches the active process to a shared memory region
+ * @param shm - shared memory id
+ * @return address of the region, 0 on error
+ */
+int ksyscall_shm_attach(int shm);
+
+/**
+ * Detaches the active process from a shared memory region
+ * @param shm - shared memory id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_shm_detach(int shm);
+
+/**
+ * Blocks the active process until the futex is woken, if the futex word
+ * still holds the expected value
+ * @param addr - address of the futex word
+ * @param val - value the caller last saw in the futex word
+ * @return 0 once woken, -1 if the value changed or on error
+ */
+int ksyscall_futex_wait(int *addr, int val);
+
+/**
+ * Wakes processes waiting on a futex
+ * @param addr - address of the futex word
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int ksyscall_futex_wake(int *addr, int count);
+
+/**
+ * Locks a priority inheritance futex for the active process
+ * @param addr - address of the futex word
+ * @return 0 once the active process owns the futex, -1 on error
+ */
+int ksyscall_futex_lock(int *addr);
+
+/**
+ * Unlocks a priority inheritance futex owned by the active process
+ * @param addr - address of the futex word
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_futex_unlock(int *addr);
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of the active process
+ * Reads of an empty pipe return 0 once every write end is closed; writes
+ * fail once every read end is closed
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_pipe(int *ends, int size);
+
+/**
+ * Closes an IO slot of the active process
+ * A pipe is released when the last IO slot referring to it is closed
+ * @param io - the IO id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_io_close(int io);
+
 
 #endif
 
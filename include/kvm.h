@@ -0,0 +1,135 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Virtual Memory - Paging
+ */
+#ifndef KVM_H
+#define KVM_H
+
+// Enables paging; when disabled every process shares the flat
+// segment-based address space
+#ifndef KVM_PAGING
+#define KVM_PAGING 1
+#endif
+
+#define KVM_ENTRIES         1024                    // Entries in a page directory or table
+#define KVM_LARGE_SHIFT     22
+#define KVM_LARGE_SIZE      (1 << KVM_LARGE_SHIFT)  // Size of a large (4MB) page
+
+// Page directory / page table entry flags
+#define KVM_PRESENT         0x001   // Entry is present
+#define KVM_WRITE           0x002   // Page is writable
+#define KVM_USER            0x004   // Page is accessible from ring 3
+#define KVM_LARGE           0x080   // Directory entry maps a large (4MB) page
+#define KVM_GLOBAL          0x100   // Translation survives address space switches
+#define KVM_OWNED           0x200   // Page is released with the address space (available bit)
+#define KVM_COW             0x400   // Page is copied on the first write to it (available bit)
+
+#define KVM_ADDR_MASK       0xfffff000
+
+// Process stacks -> each address space reserves a stack range below
+// KVM_STACK_TOP that is backed by zero pages as it is first touched
+// The lowest page of the range is never mapped to catch overflows
+#define KVM_STACK_TOP       0xc0000000
+
+#ifndef KVM_STACK_MAX
+#define KVM_STACK_MAX       (1024 * 1024)
+#endif
+
+// Size of the stack used to handle page faults
+#define KVM_FAULT_STACK_SIZE 4096
+
+/**
+ * Initializes paging
+ * The kernel image, kernel heap and low memory are identity mapped with
+ * global large pages in every address space
+ */
+void kvm_init(void);
+
+/**
+ * Indicates if paging is enabled
+ * @return non-zero if paging is enabled
+ */
+int kvm_enabled(void);
+
+/**
+ * Creates an address space
+ * The kernel mappings are shared by all address spaces
+ * @return pointer to the page directory, NULL if paging is disabled or no memory is available
+ */
+unsigned int *kvm_dir_create(void);
+
+/**
+ * Destroys an address space, releasing its page tables and the pages it owns
+ * @param dir - pointer to the page directory
+ */
+void kvm_dir_destroy(unsigned int *dir);
+
+/**
+ * Creates a copy of an address space
+ * Pages the address space owns are shared with the copy and made read-only
+ * in both; each side gets its own copy of a page the first time it writes
+ * to it. The cost is proportional to the number of page table entries.
+ * The kernel mappings (including the data of user programs, which are
+ * linked into the kernel image) stay shared and writable in both.
+ * @param dir - pointer to the page directory to copy
+ * @return pointer to the new page directory, NULL if no memory is available
+ */
+unsigned int *kvm_dir_clone(unsigned int *dir);
+
+/**
+ * Gives an address space its own writable copy of a copy-on-write page
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address within the page
+ * @return physical address of the page, NULL if the page is not copy-on-write or no memory is available
+ */
+unsigned char *kvm_cow_break(unsigned int *dir, unsigned int vaddr);
+
+/**
+ * Returns the number of copy-on-write pages that have been copied
+ * @return number of pages copied
+ */
+int kvm_pages_copied(void);
+
+/**
+ * Maps a page into an address space
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address of the page
+ * @param page - physical address of the page
+ * @param flags - page table entry flags
+ * @return 0 on success, -1 if no memory is available for the page table
+ */
+int kvm_map(unsigned int *dir, unsigned int vaddr, void *page, int flags);
+
+/**
+ * Removes the mapping of a page from an address space
+ * The page itself is not released
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address of the page
+ */
+void kvm_unmap(unsigned int *dir, unsigned int vaddr);
+
+/**
+ * Looks up the page table entry of a virtual address
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address
+ * @return pointer to the page table entry, NULL if there is no page table
+ */
+unsigned int *kvm_lookup(unsigned int *dir, unsigned int vaddr);
+
+/**
+ * Sets up the stack range of an address space
+ * Only the top page is mapped; the rest is mapped as it is first touched
+ * @param dir - pointer to the page directory
+ * @return physical address of the top stack page, NULL if no memory is available
+ */
+unsigned char *kvm_stack_create(unsigned int *dir);
+
+/**
+ * Prints the paging statistics to the kernel log
+ */
+void kvm_dump(void);
+
+#endif
@@ -0,0 +1,80 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Intrusive doubly-linked list implementation
+ */
+#ifndef LIST_H
+#define LIST_H
+
+#include <spede/stdbool.h>    // For bool type
+#include <spede/stddef.h>     // For offsetof
+
+// List node; embedded in the data structure being linked
+typedef struct list_node_t {
+    struct list_node_t *prev;   // Previous node in the list
+    struct list_node_t *next;   // Next node in the list
+} list_node_t;
+
+typedef struct list_t {
+    list_node_t *head;          // First node in the list
+    list_node_t *tail;          // Last node in the list
+    int size;                   // Number of nodes in the list
+} list_t;
+
+/**
+ * Obtains a pointer to the structure that a list node is embedded in
+ * @param node - pointer to the list node
+ * @param type - type of the containing structure
+ * @param member - name of the list node member within the structure
+ */
+#define list_entry(node, type, member) \
+    ((type *)((char *)(node) - offsetof(type, member)))
+
+/**
+ * Initializes an empty list
+ * @param  list - pointer to the list
+ * @return -1 on error; 0 on success
+ */
+int list_init(list_t *list);
+
+/**
+ * Adds a node to the end of a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to add
+ * @return -1 on error; 0 on success
+ */
+int list_append(list_t *list, list_node_t *node);
+
+/**
+ * Adds a node to the beginning of a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to add
+ * @return -1 on error; 0 on success
+ */
+int list_prepend(list_t *list, list_node_t *node);
+
+/**
+ * Removes a node from a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to remove (must be in the list)
+ * @return -1 on error; 0 on success
+ */
+int list_remove(list_t *list, list_node_t *node);
+
+/**
+ * Removes the first node from a list
+ * @param  list - pointer to the list
+ * @return pointer to the node removed, NULL if the list is empty
+ */
+list_node_t *list_pop(list_t *list);
+
+/**
+ * Indicates if the list is empty
+ * @param list - pointer to the list
+ * @return true if empty, false if not empty
+ */
+bool list_is_empty(list_t *list);
+
+#endif
@@ -6,4 +6,15 @@ void prog_shell(void);
 void prog_ping(void);
 void prog_pong(void);
 
+void prog_bench_ping(void);
+void prog_bench_pong(void);
+void prog_bench_spawn(void);
+void prog_bench_shm_producer(void);
+void prog_bench_shm_consumer(void);
+void prog_bench_ringbuf_producer(void);
+void prog_bench_ringbuf_consumer(void);
+void prog_bench_fpu(void);
+void prog_bench_lock(void);
+void prog_bench_pipe(void);
+
 #endif
@@ -0,0 +1,86 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Intrusive red-black tree implementation
+ */
+#ifndef RBTREE_H
+#define RBTREE_H
+
+#include <spede/stdbool.h>    // For bool type
+#include <spede/stddef.h>     // For offsetof
+
+// Tree node; embedded in the data structure being sorted
+typedef struct rbtree_node_t {
+    struct rbtree_node_t *parent;   // Parent node, NULL for the root
+    struct rbtree_node_t *left;     // Left child (sorts before this node)
+    struct rbtree_node_t *right;    // Right child (sorts after this node)
+    int red;                        // Node color; non-zero if red
+} rbtree_node_t;
+
+typedef struct rbtree_t {
+    rbtree_node_t *root;            // Root of the tree
+    rbtree_node_t *first;           // Leftmost node; cached for constant time lookup
+    int size;                       // Number of nodes in the tree
+} rbtree_t;
+
+// Ordering function; returns non-zero if node a sorts before node b
+typedef int (*rbtree_before_t)(rbtree_node_t *a, rbtree_node_t *b);
+
+/**
+ * Obtains a pointer to the structure that a tree node is embedded in
+ * @param node - pointer to the tree node
+ * @param type - type of the containing structure
+ * @param member - name of the tree node member within the structure
+ */
+#define rbtree_entry(node, type, member) \
+    ((type *)((char *)(node) - offsetof(type, member)))
+
+/**
+ * Initializes an empty tree
+ * @param  tree - pointer to the tree
+ * @return -1 on error; 0 on success
+ */
+int rbtree_init(rbtree_t *tree);
+
+/**
+ * Inserts a node into a tree
+ * Nodes that compare equal are placed after the existing ones
+ * @param  tree - pointer to the tree
+ * @param  node - pointer to the node to insert
+ * @param  before - ordering function
+ * @return -1 on error; 0 on success
+ */
+int rbtree_insert(rbtree_t *tree, rbtree_node_t *node, rbtree_before_t before);
+
+/**
+ * Removes a node from a tree
+ * @param  tree - pointer to the tree
+ * @param  node - pointer to the node to remove (must be in the tree)
+ * @return -1 on error; 0 on success
+ */
+int rbtree_remove(rbtree_t *tree, rbtree_node_t *node);
+
+/**
+ * Returns the first (leftmost) node of a tree
+ * @param  tree - pointer to the tree
+ * @return pointer to the first node, NULL if the tree is empty
+ */
+rbtree_node_t *rbtree_first(rbtree_t *tree);
+
+/**
+ * Returns the node that follows a node in tree order
+ * @param  node - pointer to a node in the tree
+ * @return pointer to the next node, NULL if it is the last node
+ */
+rbtree_node_t *rbtree_next(rbtree_node_t *node);
+
+/**
+ * Indicates if the tree is empty
+ * @param tree - pointer to the tree
+ * @return true if empty, false if not empty
+ */
+bool rbtree_is_empty(rbtree_t *tree);
+
+#endif
@@ -12,6 +12,8 @@
 #include <spede/stdbool.h>    // For bool type
 #include <spede/stddef.h>     // For size_t
 
+#include "list.h"
+
 #ifndef RINGBUF_SIZE
 #define RINGBUF_SIZE 2048
 #endif
@@ -21,6 +23,11 @@ typedef struct ringbuf_t {
     int tail;                   // Tail of the buffer
     int size;                   // Current size of the buffer
     char data[RINGBUF_SIZE];   // Data in buffer
+    list_t readers;             // Processes blocked until data is written (kept by flushes)
+    list_t writers;             // Processes blocked until data is read (kept by flushes)
+    int capacity;               // Number of bytes the buffer holds (up to RINGBUF_SIZE)
+    int read_ends;              // Number of pipe read ends bound into process IO slots
+    int write_ends;             // Number of pipe write ends bound into process IO slots
 } ringbuf_t;
 
 /**
@@ -32,6 +39,18 @@ typedef struct ringbuf_t {
  */
 int ringbuf_init(ringbuf_t *buf);
 
+/**
+ * Allocates an empty ring buffer from the kernel heap
+ * @return pointer to the ring buffer, NULL if no memory is available
+ */
+ringbuf_t *ringbuf_alloc(void);
+
+/**
+ * Returns a ring buffer to the kernel heap
+ * @param buf - pointer to the ring buffer structure
+ */
+void ringbuf_free(ringbuf_t *buf);
+
 /**
  * Writes a byte to the buffer
  * @param  buf   - pointer to the ring buffer structure
@@ -59,6 +78,15 @@ int ringbuf_read(ringbuf_t *buf, char *byte);
  */
 int ringbuf_write_mem(ringbuf_t *buf, char *mem, size_t size);
 
+/**
+ * Copies as many bytes to the buffer from the specified memory as fit
+ * @param buf - pointer to the ring buffer structure
+ * @param mem - pointer to the memory location to copy from
+ * @param size - number of bytes to copy
+ * @return -1 on error, otherwise the number of bytes copied
+ */
+int ringbuf_write_partial(ringbuf_t *buf, char *mem, size_t size);
+
 /**
  * Copies multiple bytes from the buffer to the specified memory
  * @param buf - pointer to the ring buffer structure
@@ -10,10 +10,52 @@
 
 #include "kproc.h"
 
+// Best-effort scheduling class selected at boot
+//   "mlfq" - priority run queues with multilevel feedback
+//   "cfs"  - completely fair; weighted virtual run time
+#ifndef SCHEDULER_CLASS
+#define SCHEDULER_CLASS "mlfq"
+#endif
+
 #ifndef SCHEDULER_TIMESLICE
 #define SCHEDULER_TIMESLICE 10
 #endif
 
+// Number of feedback levels a process may be demoted below its priority
+// Each level doubles the time slice of the level above it
+#ifndef SCHEDULER_FEEDBACK_LEVELS
+#define SCHEDULER_FEEDBACK_LEVELS 4
+#endif
+
+// Set to 0 to disable directed handoff when a semaphore is posted
+// or a mutex is unlocked to a waiting process
+#ifndef SCHEDULER_HANDOFF
+#define SCHEDULER_HANDOFF 1
+#endif
+
+// Number of ticks between anti-starvation boosts
+#ifndef SCHEDULER_BOOST_INTERVAL
+#define SCHEDULER_BOOST_INTERVAL 100
+#endif
+
+// Fair scheduler: number of ticks in which every ready process should run
+// once; divided among the processes by weight to form their time slices
+#ifndef SCHEDULER_CFS_LATENCY
+#define SCHEDULER_CFS_LATENCY 20
+#endif
+
+// Fair scheduler: minimum time slice in ticks, also how far ahead in
+// virtual run time a process must be before a woken process preempts it
+#ifndef SCHEDULER_CFS_GRANULARITY
+#define SCHEDULER_CFS_GRANULARITY 2
+#endif
+
+// Share of the CPU, in tenths of a percent, that periodic processes may
+// reserve in total; the rest is left to the other processes
+#ifndef SCHEDULER_RT_UTILIZATION
+#define SCHEDULER_RT_UTILIZATION 800
+#endif
+
 
 /**
  * Initializes the scheduler, data structures, etc.
@@ -41,8 +83,91 @@ void scheduler_remove(proc_t *proc);
 /**
  * Puts a process to sleep
  * @param proc - pointer to the process entry
- * @param seconds - number of seconds to sleep
+ * @param time - number of timer ticks to sleep
+ */
+void scheduler_sleep(proc_t *proc, int time);
+
+/**
+ * Yields the CPU; the process is placed at the end of its run queue
+ * @param proc - pointer to the process entry
+ */
+void scheduler_yield(proc_t *proc);
+
+/**
+ * Blocks a process on a wait queue
+ * The process is removed from the scheduler until it is woken up
+ * @param proc - pointer to the process entry
+ * @param queue - pointer to the wait queue
+ */
+void scheduler_wait(proc_t *proc, list_t *queue);
+
+/**
+ * Wakes up the first process waiting on a wait queue
+ * The process is added back to the scheduler
+ * @param queue - pointer to the wait queue
+ * @return pointer to the process entry woken up, NULL if none were waiting
+ */
+proc_t *scheduler_wake(list_t *queue);
+
+/**
+ * Hands the rest of the active process' time slice to a process that is
+ * ready to run, which is switched in when the kernel context is exited
+ * The active process is added back to the scheduler
+ * @param proc - pointer to the process entry to switch to
+ */
+void scheduler_handoff(proc_t *proc);
+
+/**
+ * Boosts an interactive process ahead of the other processes in its class
+ * If the process is in a run queue it is moved to the front
+ * @param proc - pointer to the process entry
+ */
+void scheduler_boost(proc_t *proc);
+
+/**
+ * Sets the scheduling priority of a process
+ * If the process is in a run queue it is moved to the new priority level
+ * @param proc - pointer to the process entry
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int scheduler_set_priority(proc_t *proc, int priority);
+
+/**
+ * Sets the effective scheduling priority of a process without changing
+ * the priority set for it
+ * If the process is in a run queue it is moved to the new priority level
+ * @param proc - pointer to the process entry
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ */
+void scheduler_set_effective_priority(proc_t *proc, int priority);
+
+/**
+ * Makes a process periodic, or a regular process again
+ * Periodic processes run ahead of all other processes, earliest deadline
+ * first. Each period a job is released that must complete (by yielding)
+ * before the next release, using no more than its budget of CPU time.
+ * A process is only admitted if the total utilization of the periodic
+ * processes stays within SCHEDULER_RT_UTILIZATION
+ * @param proc - pointer to the process entry
+ * @param period - number of ticks between job releases, 0 to clear
+ * @param budget - number of ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int scheduler_set_periodic(proc_t *proc, int period, int budget);
+
+/**
+ * Selects the best-effort scheduling class
+ * Processes that are ready to run are moved to the new class' run queue
+ * @param name - name of the scheduling class
+ * @return 0 on success, -1 if the class does not exist
+ */
+int scheduler_set_class(char *name);
+
+/**
+ * Returns the name of the selected best-effort scheduling class
+ * @return name of the scheduling class
  */
-void scheduler_sleep(proc_t *proc, int seconds);
+char *scheduler_get_class(void);
 
 #endif
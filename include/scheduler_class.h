@@ -0,0 +1,65 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Process Scheduler - Scheduling Classes
+ */
+#ifndef SCHEDULER_CLASS_H
+#define SCHEDULER_CLASS_H
+
+#include "kproc.h"
+
+// Scheduling class operations
+// A scheduling class owns the run queue of the processes assigned to it;
+// the scheduler core handles process states, sleeping and waiting.
+// Operations marked optional may be NULL.
+typedef struct scheduler_class_t {
+    char *name;                             // Class name
+
+    void (*init)(void);                     // Initializes the class' run queue (optional)
+    void (*attach)(proc_t *proc);           // Prepares a process moving into the class (optional)
+    void (*enqueue)(proc_t *proc);          // Adds a process that is ready to run
+    void (*dequeue)(proc_t *proc);          // Removes a process that is ready to run
+    proc_t *(*pick_next)(void);             // Takes the next process to run, NULL if none are ready
+    int (*preempt)(proc_t *proc);           // Non-zero if a ready process should run ahead of a
+                                            // running process of this class or a lower one
+    void (*tick)(proc_t *proc);             // Accounts for a tick used by the running process (optional)
+    void (*wake)(proc_t *proc);             // Prepares a process that becomes ready after
+                                            // being created, sleeping or waiting (optional)
+    int (*quantum)(proc_t *proc);           // Time slice in ticks, 0 if the process has none
+    void (*release)(proc_t *proc);          // Accounts for the running process giving up
+                                            // the CPU to sleep or wait (optional)
+    void (*expire)(proc_t *proc);           // Accounts for a process that used its whole
+                                            // time slice (optional)
+    void (*yield)(proc_t *proc);            // Yields the CPU; when NULL the process is
+                                            // placed back in the run queue
+    void (*boost)(proc_t *proc);            // Moves an interactive process ahead (optional)
+} scheduler_class_t;
+
+// Real-time class; periodic processes run ahead of the best-effort class
+extern scheduler_class_t scheduler_class_rt;
+
+// Best-effort classes
+extern scheduler_class_t scheduler_class_mlfq;
+extern scheduler_class_t scheduler_class_cfs;
+
+// Best-effort class that processes not assigned a class are scheduled by
+extern scheduler_class_t *scheduler_class;
+
+/**
+ * Returns the scheduling class of a process
+ * @param proc - pointer to the process entry
+ * @return pointer to the scheduling class
+ */
+scheduler_class_t *scheduler_class_of(proc_t *proc);
+
+/**
+ * Takes a process out of its run queue until a given tick
+ * If the tick has already passed the process is added back to the scheduler
+ * @param proc - pointer to the process entry
+ * @param tick - timer tick to wake up at
+ */
+void scheduler_suspend(proc_t *proc, int tick);
+
+#endif
@@ -36,12 +36,59 @@ int proc_get_pid(void);
  */
 int proc_get_name(char *name);
 
+/**
+ * Sets the current process' scheduling priority
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int proc_set_priority(int priority);
+
+/**
+ * Gets the current process' scheduling priority
+ * @return priority level or -1 on error
+ */
+int proc_get_priority(void);
+
+/**
+ * Makes the current process periodic; each job must complete by calling
+ * proc_yield within its budget before the end of its period
+ * @param period - number of timer ticks between job releases, 0 to clear
+ * @param budget - number of timer ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int proc_set_periodic(int period, int budget);
+
+/**
+ * Creates a new process
+ * @param entry - function the process starts executing
+ * @param name - process name
+ * @param flags - PROC_SPAWN_TTY to attach the process to the current process' TTY,
+ *                PROC_SPAWN_PIPES to pass it the current process' pipe ends
+ * @return process id of the new process, -1 on error
+ */
+int proc_spawn(void (*entry)(void), char *name, int flags);
+
+/**
+ * Creates a copy of the current process
+ * Both processes continue from the return of this call
+ * Only the stack is copied; globals stay shared with the parent, so the
+ * copy must keep its state in local variables
+ * @return process id of the copy in the current process, 0 in the copy, -1 on error
+ */
+int proc_fork(void);
+
 /**
  * Puts the current process to sleep for the specified number of seconds
  * @param seconds - number of seconds the process should sleep
  */
 void proc_sleep(int seconds);
 
+/**
+ * Yields the CPU to other processes that are ready to run
+ * The current process is placed at the end of its run queue
+ */
+void proc_yield(void);
+
 /**
  * Exits the current process
  * @param exitcode An exit code to return to the parent process
@@ -49,8 +96,11 @@ void proc_sleep(int seconds);
 void proc_exit(int exitcode);
 
 /**
- * Writes up to n bytes to the process' specified IO buffer
- * @param io - the IO buffer to write to
+ * Writes n bytes to the process' specified IO buffer
+ * Blocks until all of the bytes are copied; with PROC_IO_SHORT set in io,
+ * returns once some are copied, and with PROC_IO_NONBLOCK set, copies only
+ * what fits without blocking
+ * @param io - the IO buffer to write to, optionally with IO flags
  * @param buf - the buffer to copy from
  * @param n - number of bytes to write
  * @return -1 on error or value indicating number of bytes copied
@@ -59,7 +109,10 @@ int io_write(int io, char *buf, int n);
 
 /**
  * Reads up to n bytes from the process' specified IO buffer
- * @param io - the IO buffer to read from
+ * Blocks until data is available unless PROC_IO_NONBLOCK is set in io;
+ * returns 0 at the end of a pipe
+ * @param io - the IO buffer to read from, optionally with PROC_IO_NONBLOCK
+ *             (PROC_IO_SHORT is accepted; reads never wait for all n bytes)
  * @param buf - the buffer to copy to
  * @param n - number of bytes to read
  * @return -1 on error or value indicating number of bytes copied
@@ -128,4 +181,79 @@ int sem_wait(int sem);
  */
 int sem_post(int sem);
 
+/**
+ * Creates a shared memory region and attaches the current process to it
+ * The region starts out clear and is released when the last process
+ * detaches from it (or exits)
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id
+ */
+int shm_create(int size);
+
+/**
+ * Attaches the current process to a shared memory region
+ * @param shm - shared memory id
+ * @return address of the region, NULL on error
+ */
+void *shm_attach(int shm);
+
+/**
+ * Detaches the current process from a shared memory region
+ * @param shm - shared memory id
+ * @return -1 on error, 0 on success
+ */
+int shm_detach(int shm);
+
+/**
+ * Blocks the current process until the futex is woken, if the futex word
+ * still holds the expected value
+ * @param addr - address of the futex word
+ * @param val - value the caller last saw in the futex word
+ * @return 0 once woken, -1 if the value changed or on error
+ */
+int futex_wait(volatile int *addr, int val);
+
+/**
+ * Wakes processes waiting on a futex
+ * @param addr - address of the futex word
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int futex_wake(volatile int *addr, int count);
+
+/**
+ * Locks a priority inheritance futex that is held by another process
+ * The owner runs at the current process' priority until the futex is
+ * passed to the current process
+ * @param addr - address of the futex word
+ * @return 0 once the current process owns the futex, -1 on error
+ */
+int futex_lock(volatile int *addr);
+
+/**
+ * Unlocks a priority inheritance futex that processes are blocked on
+ * The futex is passed to the highest priority process waiting on it
+ * @param addr - address of the futex word
+ * @return 0 on success, -1 if the current process does not own the futex
+ */
+int futex_unlock(volatile int *addr);
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of the current process
+ * Reads of an empty pipe return 0 once every write end is closed; writes
+ * fail once every read end is closed
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return -1 on error, 0 on success
+ */
+int pipe(int *ends, int size);
+
+/**
+ * Closes an IO slot of the current process
+ * A pipe is released when the last IO slot referring to it is closed
+ * @param io - the IO id
+ * @return -1 on error, 0 on success
+ */
+int io_close(int io);
+
 #endif
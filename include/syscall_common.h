@@ -10,6 +10,24 @@
 
 #define PROC_IO_IN      0       // IO Input Id
 #define PROC_IO_OUT     1       // IO Output Id
+#define PROC_IO_AUX     2       // IO Id not used by TTYs
+
+// IO flags; combined with the IO id
+#define PROC_IO_NONBLOCK 0x100  // Read/write returns 0 instead of blocking when the buffer is empty/full
+#define PROC_IO_SHORT   0x200   // Write returns once part of the data is copied
+
+#define PROC_PRIORITY_MAX       32  // Number of process priority levels
+#define PROC_PRIORITY_HIGH      0   // Highest process priority
+#define PROC_PRIORITY_DEFAULT   16  // Default process priority
+#define PROC_PRIORITY_LOW       31  // Lowest process priority
+
+// Process spawn flags
+#define PROC_SPAWN_TTY          0x1 // Attach the new process to the parent's TTY
+#define PROC_SPAWN_PIPES        0x2 // Pass the parent's pipe ends to the new process
+
+// Priority inheritance futex words hold the owner's process id, 0 if unlocked
+#define FUTEX_PI_WAITERS        0x80000000u // Set while processes are blocked on the futex
+#define FUTEX_PI_OWNER_MASK     0x7fffffffu // Process id of the owner
 
 // Syscall identifiers
 typedef enum {
@@ -20,9 +38,15 @@ typedef enum {
     SYSCALL_SYS_GET_TIME,
     SYSCALL_SYS_GET_NAME,
     SYSCALL_PROC_SLEEP,
+    SYSCALL_PROC_YIELD,
     SYSCALL_PROC_EXIT,
     SYSCALL_PROC_GET_PID,
     SYSCALL_PROC_GET_NAME,
+    SYSCALL_PROC_SET_PRIORITY,
+    SYSCALL_PROC_GET_PRIORITY,
+    SYSCALL_PROC_SET_PERIODIC,
+    SYSCALL_PROC_SPAWN,
+    SYSCALL_PROC_FORK,
     SYSCALL_MUTEX_INIT,
     SYSCALL_MUTEX_DESTROY,
     SYSCALL_MUTEX_LOCK,
@@ -30,7 +54,16 @@ typedef enum {
     SYSCALL_SEM_INIT,
     SYSCALL_SEM_DESTROY,
     SYSCALL_SEM_WAIT,
-    SYSCALL_SEM_POST
+    SYSCALL_SEM_POST,
+    SYSCALL_SHM_CREATE,
+    SYSCALL_SHM_ATTACH,
+    SYSCALL_SHM_DETACH,
+    SYSCALL_FUTEX_WAIT,
+    SYSCALL_FUTEX_WAKE,
+    SYSCALL_FUTEX_LOCK,
+    SYSCALL_FUTEX_UNLOCK,
+    SYSCALL_PIPE,
+    SYSCALL_IO_CLOSE
 } syscall_t;
 
 #endif
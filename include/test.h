@@ -13,6 +13,8 @@
 #include "vga.h"
 #include "tty.h"
 #include "kproc.h"
+#include "syscall.h"
+#include "tsc.h"
 
 /**
  * Displays a "spinner" to show activity at the top-right corner of the
@@ -37,6 +39,7 @@ void test_timer(void) {
 
 /**
  * Displays a table with the status of all processes
+ * Only as many processes as fit on the screen are listed
  */
 void test_proc_list(void) {
     char buf[VGA_WIDTH+1] = {0};
@@ -44,34 +47,18 @@ void test_proc_list(void) {
     int bg_color = VGA_COLOR_BLACK;
     int  fg_color = VGA_COLOR_LIGHT_GREY;
     int row = 1;
+    proc_t *proc;
 
     if (tty_get_active() != 0) {
         return;
     }
 
-    // Periodically clear the screen to handle processes exiting
-    if ((timer_get_ticks() % 100) == 0) {
-        for (int r = 1; r < VGA_HEIGHT; r++) {
-            for (int c = 0; c < VGA_WIDTH; c++) {
-                vga_putc_at(c, r, bg_color, fg_color, ' ');
-            }
-        }
-    }
-
-    snprintf(buf, VGA_WIDTH, "Entry    PID   State    Time     CPU    Name");
+    snprintf(buf, VGA_WIDTH, "Entry    PID   State    Time     CPU   Pri    Vol    Inv  Miss   Ovr  Name");
     vga_puts_at(0, 0, bg_color, fg_color, buf);
 
-    for (int i = 0; i < PROC_MAX; i++) {
-        snprintf(buf, VGA_WIDTH, "%*s", VGA_WIDTH, " ");
-
-        proc_t *proc = entry_to_proc(i);
-
-        if (!proc) {
-            continue;
-        }
-
+    // The last row is kept to report processes that do not fit
+    for (proc = proc_list_first(); proc && row < VGA_HEIGHT - 1; proc = proc_list_next(proc)) {
         if (proc->state == NONE) {
-            vga_puts_at(0, row, bg_color, fg_color, buf);
             continue;
         }
 
@@ -102,30 +89,213 @@ void test_proc_list(void) {
                 break;
         }
 
-        snprintf(buf, VGA_WIDTH, "%5d  %5d  %4c  %8d  %6d    %s",
-                 i, proc->pid, state, proc->run_time, proc->cpu_time, proc->name);
+        snprintf(buf, VGA_WIDTH, "%5d  %5d  %4c  %8d  %6d  %4d  %5d  %5d  %4d  %4d  %-*s",
+                 proc->pid & PROC_PID_ENTRY_MASK, proc->pid, state, proc->run_time, proc->cpu_time, proc->priority,
+                 proc->switches_voluntary, proc->switches_involuntary,
+                 proc->deadline_misses, proc->budget_overruns, VGA_WIDTH, proc->name);
 
         vga_puts_at(0, row, bg_color, fg_color, buf);
 
         row++;
     }
 
+    fg_color = VGA_COLOR_LIGHT_GREY;
+
+    if (proc) {
+        snprintf(buf, VGA_WIDTH, "%d more processes%*s", proc_count() - (row - 1), VGA_WIDTH, " ");
+        vga_puts_at(0, row++, bg_color, fg_color, buf);
+    }
+
+    // Clear the rows below the list, left over from processes that exited
+    snprintf(buf, VGA_WIDTH, "%*s", VGA_WIDTH, " ");
+    while (row < VGA_HEIGHT) {
+        vga_puts_at(0, row++, bg_color, fg_color, buf);
+    }
+}
+
+/**
+ * Periodic process that updates the spinner 10 times per second
+ */
+void test_spinner_proc(void) {
+    if (proc_set_periodic(10, 1) != 0) {
+        proc_exit(-1);
+    }
+
+    while (1) {
+        test_spinner();
+        proc_yield();
+    }
+}
+
+/**
+ * Periodic process that updates the process list 10 times per second
+ */
+void test_proc_list_proc(void) {
+    if (proc_set_periodic(10, 1) != 0) {
+        proc_exit(-1);
+    }
+
+    while (1) {
+        test_proc_list();
+        proc_yield();
+    }
+}
+
+#ifdef PROG_BENCH
+// Number of ticks each tick overhead measurement runs for
+#define TEST_BENCH_TICKS 100
+
+// Number of processes to measure the tick overhead with
+int test_bench_tick_procs[] = { 0, 16, 64, 256, 1024, PROC_MAX };
+
+// Number of times each process scan is timed; the fastest is reported
+#define TEST_BENCH_SCANS 10
+
+// Result of the process scans, so they are not optimized away
+int test_bench_scan_sum;
+
+/**
+ * Times a scan of all processes that reads their scheduling state
+ * With cold set, a field outside the first cache line is read as well,
+ * which is what every scan cost when the scheduling state was spread
+ * across the control block
+ * @param cold - also read a field from the cold part of the control block
+ * @return CPU cycles per process of the fastest scan
+ */
+int test_bench_scan(int cold) {
+    unsigned long long best = ~0ULL;
+    unsigned long long start;
+    unsigned long long cycles;
+    proc_t *proc;
+    int sum;
+
+    for (int i = 0; i < TEST_BENCH_SCANS; i++) {
+        sum = 0;
+
+        // Keep the process list from changing during the scan
+        asm("cli");
+        start = tsc_read();
+
+        for (proc = proc_list_first(); proc; proc = proc_list_next(proc)) {
+            sum += proc->state + proc->cpu_time;
+            if (cold) {
+                sum += proc->start_time;
+            }
+        }
+
+        cycles = tsc_read() - start;
+        asm("sti");
+
+        if (cycles < best) {
+            best = cycles;
+        }
+
+        test_bench_scan_sum += sum;
+    }
+
+    return (int)(best / proc_count());
+}
+
+/**
+ * Worker process for the tick overhead benchmark
+ * Stays in the sleep queue so it is part of the process table without
+ * using the CPU
+ */
+void test_bench_tick_worker(void) {
+    while (1) {
+        proc_sleep(3600);
+    }
 }
 
+/**
+ * Tick overhead benchmark
+ * Adds worker processes in steps and, at each step, spins for a while
+ * timing the gaps in its own execution. The largest gap in a tick is the
+ * time the CPU spent in the timer interrupt (and any process that ran);
+ * the smallest of those is the cost of a tick by itself.
+ */
+void test_bench_tick_proc(void) {
+    unsigned long long prev;
+    unsigned long long now;
+    unsigned long long gap;
+    unsigned long long tick_gap;
+    unsigned long long min_gap;
+    unsigned long long total_gap;
+    int tick;
+    int start;
+
+    proc_set_priority(PROC_PRIORITY_HIGH);
+
+    for (int step = 0; step < (int)(sizeof(test_bench_tick_procs) / sizeof(int)); step++) {
+        // Add workers until the step's process count is reached
+        while (proc_count() < test_bench_tick_procs[step]) {
+            if (kproc_create(test_bench_tick_worker, "worker", PROC_TYPE_KERNEL) < 0) {
+                break;
+            }
+        }
+
+        // Let the workers run until they are all asleep
+        proc_sleep(1);
+
+        min_gap = ~0ULL;
+        total_gap = 0;
+        tick_gap = 0;
+
+        start = timer_get_ticks();
+        tick = start;
+        prev = tsc_read();
+
+        while (timer_get_ticks() - start < TEST_BENCH_TICKS) {
+            now = tsc_read();
+            gap = now - prev;
+            prev = now;
+
+            if (gap > tick_gap) {
+                tick_gap = gap;
+            }
+
+            if (timer_get_ticks() != tick) {
+                tick = timer_get_ticks();
+
+                if (tick_gap < min_gap) {
+                    min_gap = tick_gap;
+                }
+
+                total_gap += tick_gap;
+                tick_gap = 0;
+            }
+        }
+
+        kernel_log_info("bench: %d processes, tick overhead %d cycles (average %d)",
+                        proc_count(), (int)min_gap, (int)(total_gap / TEST_BENCH_TICKS));
+
+        kernel_log_info("bench: %d processes, scan %d cycles per process (%d reading a cold field)",
+                        proc_count(), test_bench_scan(0), test_bench_scan(1));
+    }
+
+    proc_exit(0);
+}
+#endif
+
 /**
  * Initializes all tests
  */
 void test_init(void) {
     kernel_log_info("Initializing test functions");
 
-    // Register the spinner to update at a rate of 10 times per second
-    timer_callback_register(&test_spinner, 10, -1);
+    // Create the spinner as a periodic process
+    kproc_create(test_spinner_proc, "spinner", PROC_TYPE_KERNEL);
 
     // Register the timer to update at a rate of 4 times per second
     timer_callback_register(&test_timer, 25, -1);
 
-    // Register the process list to update at a rate of 10 times per second
-    timer_callback_register(&test_proc_list, 10, -1);
+    // Create the process list as a periodic process
+    kproc_create(test_proc_list_proc, "proc_list", PROC_TYPE_KERNEL);
+
+#ifdef PROG_BENCH
+    // Measure the tick overhead as the number of processes grows
+    kproc_create(test_bench_tick_proc, "bench_tick", PROC_TYPE_KERNEL);
+#endif
 }
 
 #endif
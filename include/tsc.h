@@ -0,0 +1,24 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * CPU Time Stamp Counter
+ */
+#ifndef TSC_H
+#define TSC_H
+
+/**
+ * Reads the CPU time stamp counter
+ * @return number of CPU cycles since reset
+ */
+static inline unsigned long long tsc_read(void) {
+    unsigned int lo;
+    unsigned int hi;
+
+    asm volatile("rdtsc" : "=a"(lo), "=d"(hi));
+
+    return ((unsigned long long)hi << 32) | lo;
+}
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * User space locks
+ */
+#ifndef ULOCK_H
+#define ULOCK_H
+
+// Mutex whose state lives in user memory
+// The system call is only made to lock, or unlock, a contended mutex; the
+// owner's process id is kept so a blocked process can lend it its priority
+typedef struct umutex_t {
+    volatile int owner;     // Process id of the owner (FUTEX_PI_WAITERS if contended), 0 unlocked
+} umutex_t;
+
+// Semaphore whose count lives in user memory
+typedef struct usem_t {
+    volatile int count;     // The current semaphore count
+    volatile int waiters;   // Number of processes blocked (or about to block)
+} usem_t;
+
+// Static initializers
+#define UMUTEX_INIT         { 0 }
+#define USEM_INIT(value)    { (value), 0 }
+
+/**
+ * Locks the mutex
+ * @param mutex - pointer to the mutex
+ * @param pid - process id of the current process
+ * @note If the mutex is already locked, the process blocks and the owner
+ *       runs at the process' priority until the mutex is passed on
+ */
+void umutex_lock(umutex_t *mutex, int pid);
+
+/**
+ * Unlocks the mutex
+ * @param mutex - pointer to the mutex
+ * @param pid - process id of the current process
+ */
+void umutex_unlock(umutex_t *mutex, int pid);
+
+/**
+ * Waits on the semaphore
+ * @param sem - pointer to the semaphore
+ * @note If the semaphore count is 0, the process blocks
+ */
+void usem_wait(usem_t *sem);
+
+/**
+ * Posts the semaphore
+ * @param sem - pointer to the semaphore
+ */
+void usem_post(usem_t *sem);
+#endif
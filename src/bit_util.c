@@ -52,3 +52,43 @@ int bit_clear(int value, int bit) {
 int bit_toggle(int value, int bit) {
     return value;
 }
+
+/**
+ * Finds the first (least significant) bit that is set
+ * @param value - the integer value to scan
+ * @return index of the first bit set, -1 if no bits are set
+ */
+int bit_first_set(unsigned int value) {
+    int bit;
+
+    if (value == 0) {
+        return -1;
+    }
+
+    // Bit scan forward locates the lowest set bit in a single instruction
+    asm("bsfl %1, %0"
+        : "=r"(bit)
+        : "rm"(value));
+
+    return bit;
+}
+
+/**
+ * Finds the last (most significant) bit that is set
+ * @param value - the integer value to scan
+ * @return index of the last bit set, -1 if no bits are set
+ */
+int bit_last_set(unsigned int value) {
+    int bit;
+
+    if (value == 0) {
+        return -1;
+    }
+
+    // Bit scan reverse locates the highest set bit in a single instruction
+    asm("bsrl %1, %0"
+        : "=r"(bit)
+        : "rm"(value));
+
+    return bit;
+}
@@ -0,0 +1,198 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Id Tables
+ *
+ * Binds small integer ids (mutex and semaphore ids) to kernel objects.
+ * Free ids are linked through the table, so allocating and freeing an id
+ * is constant time. The table is allocated from the page allocator; it
+ * doubles when it fills up and halves when it is mostly unused, so its
+ * memory follows the number of ids in use.
+ */
+
+#include <spede/string.h>
+
+#include "idtable.h"
+#include "kernel.h"
+#include "kmem.h"
+
+/**
+ * Returns the smallest page block order that holds a number of bytes
+ * @param size - number of bytes
+ * @return page block order
+ */
+static int idtable_order(int size) {
+    int order = 0;
+
+    while ((KMEM_PAGE_SIZE << order) < size) {
+        order++;
+    }
+
+    return order;
+}
+
+/**
+ * Moves the table into a new allocation of a given number of entries
+ * Ids at or above the new size must be free. The free ids are relinked so
+ * the lowest ones are used first.
+ * @param table - pointer to the id table
+ * @param size - number of entries
+ * @return 0 on success, -1 if no memory is available
+ */
+static int idtable_resize(idtable_t *table, int size) {
+    idtable_entry_t *entries;
+    int keep = (size < table->size) ? size : table->size;
+
+    entries = kmem_page_alloc(idtable_order(size * sizeof(idtable_entry_t)));
+    if (!entries) {
+        return -1;
+    }
+
+    if (table->entries) {
+        memcpy(entries, table->entries, keep * sizeof(idtable_entry_t));
+        kmem_page_free(table->entries);
+    }
+
+    table->free_head = -1;
+    table->upper_used = 0;
+
+    for (int i = size - 1; i >= 0; i--) {
+        if (i >= keep) {
+            entries[i].object = NULL;
+        }
+
+        if (entries[i].object) {
+            entries[i].next_free = -1;
+
+            if (i >= size / 2) {
+                table->upper_used++;
+            }
+        } else {
+            entries[i].next_free = table->free_head;
+            table->free_head = i;
+        }
+    }
+
+    kernel_log_debug("Id table resized from %d to %d entries", table->size, size);
+
+    table->entries = entries;
+    table->size = size;
+
+    return 0;
+}
+
+/**
+ * Initializes an empty id table
+ * @param table - pointer to the id table
+ * @param init_size - number of entries the table starts with
+ * @param max_size - number of entries the table may grow to
+ */
+void idtable_init(idtable_t *table, int init_size, int max_size) {
+    table->entries = NULL;
+    table->size = 0;
+    table->used = 0;
+    table->upper_used = 0;
+    table->free_head = -1;
+    table->init_size = init_size;
+    table->max_size = max_size;
+}
+
+/**
+ * Binds an object to a free id
+ * The lowest free ids of a new table are used first; the table doubles
+ * in size when no id is free
+ * @param table - pointer to the id table
+ * @param object - object to bind; must not be NULL
+ * @return the id, -1 if no id is available
+ */
+int idtable_alloc(idtable_t *table, void *object) {
+    int size;
+    int id;
+
+    if (!object) {
+        return -1;
+    }
+
+    if (table->free_head < 0) {
+        if (table->size >= table->max_size) {
+            return -1;
+        }
+
+        size = table->size ? table->size * 2 : table->init_size;
+        if (size > table->max_size) {
+            size = table->max_size;
+        }
+
+        if (idtable_resize(table, size) != 0) {
+            return -1;
+        }
+    }
+
+    id = table->free_head;
+    table->free_head = table->entries[id].next_free;
+
+    table->entries[id].object = object;
+    table->entries[id].next_free = -1;
+
+    table->used++;
+    if (id >= table->size / 2) {
+        table->upper_used++;
+    }
+
+    return id;
+}
+
+/**
+ * Frees an id
+ * The table halves in size once only a quarter of its ids are in use and
+ * none of them are in its upper half
+ * @param table - pointer to the id table
+ * @param id - the id to free
+ * @return 0 on success, -1 if the id is not in use
+ */
+int idtable_free(idtable_t *table, int id) {
+    int size;
+
+    if (!idtable_get(table, id)) {
+        return -1;
+    }
+
+    table->entries[id].object = NULL;
+    table->entries[id].next_free = table->free_head;
+    table->free_head = id;
+
+    table->used--;
+    if (id >= table->size / 2) {
+        table->upper_used--;
+    }
+
+    // Shrinking at a quarter rather than at half keeps a table that hovers
+    // around a power of two from resizing on every allocation
+    if (table->size > table->init_size && table->upper_used == 0 && table->used <= table->size / 4) {
+        size = table->size / 2;
+        if (size < table->init_size) {
+            size = table->init_size;
+        }
+
+        // The table stays as it is if no memory is available
+        idtable_resize(table, size);
+    }
+
+    return 0;
+}
+
+/**
+ * Looks up the object bound to an id
+ * @param table - pointer to the id table
+ * @param id - the id
+ * @return pointer to the object, NULL if the id is not in use
+ */
+void *idtable_get(idtable_t *table, int id) {
+    if (id < 0 || id >= table->size) {
+        return NULL;
+    }
+
+    return table->entries[id].object;
+}
@@ -113,6 +113,33 @@ void interrupts_irq_register(int irq, void (*entry)(), void (*handler)()) {
     kernel_log_info("interrupts: IRQ %d (0x%02x) registered)", irq, irq);
 }
 
+/**
+ * Registers a task gate for the specified interrupt
+ * The interrupt switches to the task described by the TSS, which runs on
+ * its own stack; used for faults that can not be handled on the
+ * interrupted stack
+ * @param irq - interrupt number
+ * @param selector - GDT selector of the task's TSS
+ */
+void interrupts_task_register(int irq, int selector) {
+    unsigned short *gate;
+
+    if (irq < 0 || irq >= IRQ_MAX) {
+        kernel_panic("interrupts: Invalid IRQ %d (0x%02x)", irq, irq);
+        return;
+    }
+
+    // Task gate descriptor: the offset is unused, the access byte is
+    // present, DPL 0, type 5 (task gate)
+    gate = (unsigned short *)&idt[irq];
+    gate[0] = 0;
+    gate[1] = selector;
+    gate[2] = 0x8500;
+    gate[3] = 0;
+
+    kernel_log_info("interrupts: IRQ %d (0x%02x) registered as a task gate", irq, irq);
+}
+
 /**
  * Enables the specified IRQ on the PIC
  *
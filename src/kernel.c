@@ -12,6 +12,7 @@
 
 #include "interrupts.h"
 #include "kernel.h"
+#include "kfpu.h"
 #include "scheduler.h"
 #include "trapframe.h"
 #include "vga.h"
@@ -244,7 +245,10 @@ void kernel_context_enter(trapframe_t *trapframe) {
         kernel_panic("No active process!");
     }
 
-    // Exit the kernel context
-    kernel_context_exit(active_proc->trapframe);
+    // Trap the process' first FPU instruction unless its state is loaded
+    kfpu_switch(active_proc);
+
+    // Exit the kernel context into the process' address space
+    kernel_context_exit(active_proc->trapframe, active_proc->page_dir);
 }
 
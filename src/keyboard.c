@@ -1,11 +1,15 @@
 #include <spede/flames.h>
 #include <spede/stdio.h>
+#include <spede/string.h>
 #include <spede/machine/io.h>
 
 #include "interrupts.h"
 #include "kernel.h"
 #include "keyboard.h"
 #include "kproc.h"
+#include "kslab.h"
+#include "kvm.h"
+#include "scheduler.h"
 #include "tty.h"
 
 // Keyboard data port
@@ -441,7 +445,29 @@ unsigned int keyboard_decode(unsigned int c) {
                 }
 
                 if (c == 'n' || c == 'N') {
-                    kproc_create(kproc_test, "test", PROC_TYPE_USER);
+                    // Test processes are CPU hogs, so keep them below interactive processes
+                    proc_t *proc = pid_to_proc(kproc_create(kproc_test, "test", PROC_TYPE_USER));
+                    if (proc) {
+                        scheduler_set_priority(proc, PROC_PRIORITY_LOW);
+                    }
+                    return KEY_NULL;
+                }
+
+                if (c == 's' || c == 'S') {
+                    // Switch between the best-effort scheduling classes
+                    if (strcmp(scheduler_get_class(), "mlfq") == 0) {
+                        scheduler_set_class("cfs");
+                    } else {
+                        scheduler_set_class("mlfq");
+                    }
+                    return KEY_NULL;
+                }
+
+                if (c == 'm' || c == 'M') {
+                    // Print the kernel memory statistics
+                    kmem_cache_dump();
+                    kvm_dump();
+                    kproc_dump();
                     return KEY_NULL;
                 }
 
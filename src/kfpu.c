@@ -0,0 +1,237 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel FPU/SSE Context Handling
+ *
+ * The FPU/SSE registers are switched lazily. The registers hold the state
+ * of one process, the owner. CR0.TS is set whenever another process runs,
+ * so its first FPU instruction raises the device-not-available trap; the
+ * owner's state is saved and the new process' state restored then.
+ * Processes that never use the FPU never have their state saved, and a
+ * context switch only costs a CR0 update.
+ */
+
+#include <spede/string.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kfpu.h"
+#include "kslab.h"
+
+// CPUID feature flags (EDX of leaf 1)
+#define CPUID_FXSR  (1 << 24)   // FXSAVE/FXRSTOR
+#define CPUID_SSE   (1 << 25)   // SSE
+
+// Control register flags
+#define CR0_MP      0x00000002  // WAIT/FWAIT honor CR0.TS
+#define CR0_EM      0x00000004  // FPU is emulated
+#define CR0_TS      0x00000008  // Task switched; FPU instructions trap
+#define CR4_OSFXSR      0x00000200  // FXSAVE/FXRSTOR and SSE enabled
+#define CR4_OSXMMEXCPT  0x00000400  // SSE exceptions enabled
+
+// FPU state cache; FXSAVE requires 16 byte alignment, which objects of
+// this size get from their slab
+// States are handed out clear and must be cleared before they are freed
+kmem_cache_t fpu_cache = KMEM_CACHE("fpu", KFPU_STATE_SIZE, 0, KMEM_CACHE_ZERO);
+
+// Process whose state is loaded in the FPU, NULL if none
+proc_t *kfpu_owner;
+
+// Set if the CPU supports FXSAVE/FXRSTOR; otherwise only the x87 state
+// is switched, with FNSAVE/FRSTOR
+int kfpu_fxsr;
+
+/**
+ * Saves the FPU state
+ * @param state - state save area
+ */
+static void kfpu_save(unsigned char *state) {
+    if (kfpu_fxsr) {
+        asm volatile("fxsave (%0)" : : "r"(state) : "memory");
+    } else {
+        // FNSAVE also reinitializes the FPU
+        asm volatile("fnsave (%0)" : : "r"(state) : "memory");
+    }
+}
+
+/**
+ * Restores the FPU state
+ * @param state - state save area
+ */
+static void kfpu_restore(unsigned char *state) {
+    if (kfpu_fxsr) {
+        asm volatile("fxrstor (%0)" : : "r"(state) : "memory");
+    } else {
+        asm volatile("frstor (%0)" : : "r"(state) : "memory");
+    }
+}
+
+/**
+ * Sets CR0.TS so the next FPU instruction traps
+ */
+static void kfpu_trap_set(void) {
+    unsigned int cr0;
+
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+    if (!(cr0 & CR0_TS)) {
+        asm volatile("movl %0, %%cr0" : : "r"(cr0 | CR0_TS));
+    }
+}
+
+/**
+ * Saves the owner's state and leaves the FPU unowned
+ */
+static void kfpu_unload(void) {
+    if (!kfpu_owner) {
+        return;
+    }
+
+    asm volatile("clts");
+    kfpu_save(kfpu_owner->fpu_state);
+    kfpu_owner = NULL;
+    kfpu_trap_set();
+}
+
+/**
+ * Device-not-available trap handler
+ * Switches the FPU to the active process; a process' first FPU instruction
+ * starts it out with a clean state
+ */
+void kfpu_irq_handler(void) {
+    proc_t *proc = active_proc;
+
+    asm volatile("clts");
+
+    // The owner traps when CR0.TS was set by a hardware task switch (page
+    // fault handling); its state is still loaded
+    if (!proc || proc == kfpu_owner) {
+        return;
+    }
+
+    if (!proc->fpu_state) {
+        proc->fpu_state = kmem_cache_alloc(&fpu_cache);
+        if (!proc->fpu_state) {
+            kernel_panic("fpu: unable to allocate the FPU state of process %d", proc->pid);
+            return;
+        }
+    }
+
+    if (kfpu_owner) {
+        kfpu_save(kfpu_owner->fpu_state);
+    }
+
+    if (proc->fpu_state[KFPU_STATE_SIZE - 1]) {
+        kfpu_restore(proc->fpu_state);
+    } else {
+        // First use; the last byte of the area is never used by the CPU,
+        // so it marks the area as holding a saved state
+        asm volatile("fninit");
+        proc->fpu_state[KFPU_STATE_SIZE - 1] = 1;
+    }
+
+    kfpu_owner = proc;
+}
+
+/**
+ * Prepares the FPU for a process about to run
+ * The FPU is left usable only if the process owns the loaded state; any
+ * other process traps on its first FPU instruction and the state is
+ * switched then
+ * @param proc - process about to run
+ */
+void kfpu_switch(proc_t *proc) {
+    unsigned int cr0;
+
+    asm volatile("movl %%cr0, %0" : "=r"(cr0));
+
+    if (proc && proc == kfpu_owner) {
+        if (cr0 & CR0_TS) {
+            asm volatile("clts");
+        }
+    } else if (!(cr0 & CR0_TS)) {
+        asm volatile("movl %0, %%cr0" : : "r"(cr0 | CR0_TS));
+    }
+}
+
+/**
+ * Gives a forked process a copy of its parent's FPU state
+ * @param parent - process that was forked
+ * @param child - copy of the process
+ * @return 0 on success, -1 if no memory is available
+ */
+int kfpu_fork(proc_t *parent, proc_t *child) {
+    if (!parent->fpu_state) {
+        return 0;
+    }
+
+    child->fpu_state = kmem_cache_alloc(&fpu_cache);
+    if (!child->fpu_state) {
+        return -1;
+    }
+
+    // The parent's latest state may only be in the FPU registers
+    if (parent == kfpu_owner) {
+        kfpu_unload();
+    }
+
+    memcpy(child->fpu_state, parent->fpu_state, KFPU_STATE_SIZE);
+
+    return 0;
+}
+
+/**
+ * Releases a process' FPU state
+ * @param proc - process being destroyed
+ */
+void kfpu_release(proc_t *proc) {
+    if (proc == kfpu_owner) {
+        kfpu_owner = NULL;
+    }
+
+    if (proc->fpu_state) {
+        memset(proc->fpu_state, 0, KFPU_STATE_SIZE);
+        kmem_cache_free(&fpu_cache, proc->fpu_state);
+        proc->fpu_state = NULL;
+    }
+}
+
+/**
+ * Initializes the FPU and registers the device-not-available handler
+ * The FPU starts out unowned; the first process to use it takes it over
+ */
+void kfpu_init(void) {
+    unsigned int eax = 1;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+    unsigned int reg;
+
+    asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+
+    kfpu_fxsr = (edx & CPUID_FXSR) != 0;
+
+    // Enable FXSAVE/FXRSTOR and SSE if supported
+    if (kfpu_fxsr) {
+        asm volatile("movl %%cr4, %0" : "=r"(reg));
+        reg |= CR4_OSFXSR;
+        if (edx & CPUID_SSE) {
+            reg |= CR4_OSXMMEXCPT;
+        }
+        asm volatile("movl %0, %%cr4" : : "r"(reg));
+    }
+
+    // Use the FPU (rather than emulating it), with WAIT honoring CR0.TS
+    asm volatile("movl %%cr0, %0" : "=r"(reg));
+    reg = (reg & ~CR0_EM) | CR0_MP;
+    asm volatile("movl %0, %%cr0" : : "r"(reg));
+
+    asm volatile("fninit");
+
+    interrupts_irq_register(IRQ_FPU, isr_entry_fpu, kfpu_irq_handler);
+
+    kfpu_trap_set();
+
+    kernel_log_info("fpu: lazy switching enabled (%s)", kfpu_fxsr ? "FXSAVE" : "FNSAVE");
+}
@@ -0,0 +1,335 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Futexes
+ *
+ * User space locks keep their state in a word of user memory and update it
+ * with atomic instructions; the kernel is only entered to block when the
+ * lock is contended and to wake the blocked processes. Waiters are keyed
+ * by the physical address of the word, so processes sharing the memory
+ * (kernel image data or shared memory regions) find each other's waiters.
+ *
+ * Priority inheritance futexes keep the owner's process id in the word, so
+ * a process that blocks on one can lend its priority to the owner. The
+ * kernel passes the futex to the highest priority waiter when it is
+ * unlocked, writing the new owner into the word.
+ */
+
+#include "kernel.h"
+#include "kfutex.h"
+#include "kmem.h"
+#include "kmutex.h"
+#include "kvm.h"
+#include "scheduler.h"
+
+// Wait queues; waiters on different futexes may share a queue
+list_t kfutex_buckets[KFUTEX_BUCKETS];
+
+/**
+ * Returns the key of a futex word
+ * @param proc - process the address belongs to
+ * @param addr - address of the futex word in the process
+ * @return physical address of the futex word
+ */
+static unsigned int kfutex_key(proc_t *proc, int *addr) {
+    unsigned int *pte;
+
+    if (!proc->page_dir) {
+        return (unsigned int)addr;
+    }
+
+    // Memory outside the process' own mappings is identity mapped
+    pte = kvm_lookup(proc->page_dir, (unsigned int)addr);
+    if (!pte || !(*pte & KVM_PRESENT)) {
+        return (unsigned int)addr;
+    }
+
+    return (*pte & KVM_ADDR_MASK) | ((unsigned int)addr & (KMEM_PAGE_SIZE - 1));
+}
+
+/**
+ * Returns the wait queue of a futex
+ * @param key - futex key
+ * @return pointer to the wait queue
+ */
+static list_t *kfutex_bucket(unsigned int key) {
+    return &kfutex_buckets[(key >> 2) % KFUTEX_BUCKETS];
+}
+
+/**
+ * Blocks a process until the futex is woken, if the futex word still
+ * holds the expected value
+ * @param proc - process to block
+ * @param addr - address of the futex word in the process
+ * @param val - value the caller last saw in the futex word
+ * @return 0 if the process was blocked, -1 if the value changed or on error
+ */
+int kfutex_wait(proc_t *proc, int *addr, int val) {
+    if (!proc || !addr || ((unsigned int)addr & 3)) {
+        return -1;
+    }
+
+    // The kernel is not preempted, so a wake can not be missed between
+    // this check and blocking
+    if (*addr != val) {
+        return -1;
+    }
+
+    proc->futex_key = kfutex_key(proc, addr);
+    scheduler_wait(proc, kfutex_bucket(proc->futex_key));
+
+    return 0;
+}
+
+/**
+ * Wakes processes waiting on a futex
+ * @param proc - process waking the futex
+ * @param addr - address of the futex word in the process
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int kfutex_wake(proc_t *proc, int *addr, int count) {
+    unsigned int key;
+    list_t *bucket;
+    list_node_t *node;
+    list_node_t *next;
+    proc_t *waiter;
+    int woken = 0;
+
+    if (!proc || !addr || ((unsigned int)addr & 3)) {
+        return -1;
+    }
+
+    key = kfutex_key(proc, addr);
+    bucket = kfutex_bucket(key);
+
+    // Waiters are woken in the order they blocked
+    for (node = bucket->head; node && woken < count; node = next) {
+        next = node->next;
+        waiter = list_entry(node, proc_t, scheduler_node);
+
+        // Priority inheritance futex waiters are only woken by an unlock
+        if (waiter->futex_key != key || waiter->futex_owner) {
+            continue;
+        }
+
+        scheduler_remove(waiter);
+        waiter->futex_key = 0;
+        scheduler_add(waiter);
+        woken++;
+    }
+
+    return woken;
+}
+
+/**
+ * Passes a priority inheritance futex to the highest priority process
+ * waiting on it
+ * Waiters of the same priority are taken in the order they blocked. The
+ * new owner is added back to the scheduler and inherits from the processes
+ * still waiting; without waiters the futex is left unlocked
+ * @param word - pointer to the futex word
+ * @param key - futex key
+ * @return pointer to the new owner, NULL if no process was waiting
+ */
+static proc_t *kfutex_pass(int *word, unsigned int key) {
+    list_t *bucket = kfutex_bucket(key);
+    list_node_t *node;
+    proc_t *waiter;
+    proc_t *top = NULL;
+    int waiters = 0;
+
+    for (node = bucket->head; node; node = node->next) {
+        waiter = list_entry(node, proc_t, scheduler_node);
+        if (waiter->futex_key != key || !waiter->futex_owner) {
+            continue;
+        }
+
+        waiters++;
+        if (!top || waiter->priority < top->priority) {
+            top = waiter;
+        }
+    }
+
+    if (!top) {
+        *word = 0;
+        return NULL;
+    }
+
+    // The processes still waiting now wait on the new owner
+    for (node = bucket->head; node; node = node->next) {
+        waiter = list_entry(node, proc_t, scheduler_node);
+        if (waiter->futex_key == key && waiter->futex_owner) {
+            waiter->futex_owner = top->pid;
+        }
+    }
+
+    *word = (int)((unsigned int)top->pid | (waiters > 1 ? FUTEX_PI_WAITERS : 0));
+
+    scheduler_remove(top);
+    top->futex_key = 0;
+    top->futex_owner = 0;
+    scheduler_add(top);
+
+    scheduler_set_effective_priority(top, kmutex_priority(top));
+
+    return top;
+}
+
+/**
+ * Locks a priority inheritance futex
+ * The futex word holds the owner's process id. If another process owns the
+ * futex, the process blocks and the owner runs at the process' priority
+ * until the futex is passed on
+ * @param proc - process locking the futex
+ * @param addr - address of the futex word in the process
+ * @return 0 once the process owns the futex, -1 on error
+ */
+int kfutex_lock(proc_t *proc, int *addr) {
+    unsigned int word;
+    proc_t *owner;
+
+    if (!proc || !addr || ((unsigned int)addr & 3)) {
+        return -1;
+    }
+
+    // The kernel is not preempted, so the word can not change between
+    // reading the owner and blocking
+    word = (unsigned int)*addr;
+
+    // The owner unlocked the futex before the process entered the kernel
+    if (word == 0) {
+        *addr = proc->pid;
+        return 0;
+    }
+
+    if ((word & FUTEX_PI_OWNER_MASK) == (unsigned int)proc->pid) {
+        kernel_log_warn("futex: process %d already owns the futex", proc->pid);
+        return -1;
+    }
+
+    // The owner exited without unlocking the futex and nothing was waiting
+    // on it to take it over
+    owner = pid_to_proc((int)(word & FUTEX_PI_OWNER_MASK));
+    if (!owner) {
+        *addr = (int)((unsigned int)proc->pid | (word & FUTEX_PI_WAITERS));
+        return 0;
+    }
+
+    // Mark the futex as having waiters so the owner's unlock enters the
+    // kernel, and block until the futex is passed to the process
+    *addr = (int)(word | FUTEX_PI_WAITERS);
+
+    proc->futex_key = kfutex_key(proc, addr);
+    proc->futex_owner = owner->pid;
+    scheduler_wait(proc, kfutex_bucket(proc->futex_key));
+
+    kmutex_inherit(owner, proc->priority);
+
+    return 0;
+}
+
+/**
+ * Unlocks a priority inheritance futex
+ * The futex is passed to the highest priority process waiting on it, and
+ * the previous owner's effective priority drops back to what the locks it
+ * still holds require
+ * @param proc - process unlocking the futex
+ * @param addr - address of the futex word in the process
+ * @return 0 on success, -1 if the process does not own the futex or on error
+ */
+int kfutex_unlock(proc_t *proc, int *addr) {
+    if (!proc || !addr || ((unsigned int)addr & 3)) {
+        return -1;
+    }
+
+    if (((unsigned int)*addr & FUTEX_PI_OWNER_MASK) != (unsigned int)proc->pid) {
+        kernel_log_warn("futex: process %d does not own the futex", proc->pid);
+        return -1;
+    }
+
+    kfutex_pass(addr, kfutex_key(proc, addr));
+    scheduler_set_effective_priority(proc, kmutex_priority(proc));
+
+    return 0;
+}
+
+/**
+ * Returns the highest priority process waiting on a priority inheritance
+ * futex owned by a process
+ * @param owner - pointer to the owner
+ * @return pointer to the process, NULL if no process is waiting
+ */
+proc_t *kfutex_waiter_top(proc_t *owner) {
+    proc_t *top = NULL;
+    proc_t *waiter;
+
+    for (int i = 0; i < KFUTEX_BUCKETS; i++) {
+        for (list_node_t *node = kfutex_buckets[i].head; node; node = node->next) {
+            waiter = list_entry(node, proc_t, scheduler_node);
+            if (!waiter->futex_owner || waiter->futex_owner != owner->pid) {
+                continue;
+            }
+
+            if (!top || waiter->priority < top->priority) {
+                top = waiter;
+            }
+        }
+    }
+
+    return top;
+}
+
+/**
+ * Releases the futexes of a process that is exiting
+ * The process stops waiting on a futex, and each priority inheritance
+ * futex it owns is passed to the highest priority process waiting on it
+ * @param proc - pointer to the process
+ */
+void kfutex_release(proc_t *proc) {
+    proc_t *owner;
+    proc_t *waiter;
+
+    if (!proc) {
+        return;
+    }
+
+    // The owner no longer inherits the process' priority
+    if (proc->futex_owner) {
+        owner = pid_to_proc(proc->futex_owner);
+
+        if (proc->scheduler_queue == kfutex_bucket(proc->futex_key)) {
+            scheduler_remove(proc);
+        }
+
+        proc->futex_key = 0;
+        proc->futex_owner = 0;
+
+        if (owner) {
+            kmutex_update(owner);
+        }
+    }
+
+    // Passing a futex moves its remaining waiters to the new owner, so this
+    // ends once nothing waits on the process
+    while ((waiter = kfutex_waiter_top(proc)) != NULL) {
+        kernel_log_warn("futex: process %d exited holding a mutex", proc->pid);
+
+        // The key is the physical address of the word, which is identity
+        // mapped in every address space
+        kfutex_pass((int *)waiter->futex_key, waiter->futex_key);
+    }
+}
+
+/**
+ * Initializes the futex wait queues
+ */
+void kfutex_init(void) {
+    kernel_log_info("Initializing futexes");
+
+    for (int i = 0; i < KFUTEX_BUCKETS; i++) {
+        list_init(&kfutex_buckets[i]);
+    }
+}
@@ -0,0 +1,275 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Memory - Buddy Page Allocator
+ *
+ * Manages the memory above the kernel image in blocks of 2^order pages.
+ * A free block is split in halves (buddies) until it is the size that was
+ * requested; a freed block is merged with its buddy whenever the buddy is
+ * also free.
+ *
+ * The amount of memory is fixed at build time (KMEM_SIZE); it is checked
+ * against the memory the BIOS found, read from the CMOS, so a machine
+ * that is too small stops at boot instead of handing out missing pages.
+ */
+
+#include <spede/string.h>
+#include <spede/machine/io.h>
+
+#include "kernel.h"
+#include "kmem.h"
+
+// CMOS registers holding the memory the BIOS found
+#define KMEM_CMOS_ADDR      0x70
+#define KMEM_CMOS_DATA      0x71
+#define KMEM_CMOS_EXT_LOW   0x30    // KB above 1 MB (up to 64 MB), low byte
+#define KMEM_CMOS_EXT_HIGH  0x31    // KB above 1 MB (up to 64 MB), high byte
+#define KMEM_CMOS_HIGH_LOW  0x34    // 64 KB blocks above 16 MB, low byte
+#define KMEM_CMOS_HIGH_HIGH 0x35    // 64 KB blocks above 16 MB, high byte
+
+// End of the kernel image; provided by the linker
+extern char end[];
+
+// Start of the managed memory (page aligned)
+unsigned char *kmem_base;
+
+// Page descriptors
+kmem_page_t kmem_pages[KMEM_PAGES];
+
+// Free blocks of each order
+list_t kmem_free_area[KMEM_ORDER_MAX];
+
+// Number of free pages
+int kmem_free_count;
+
+/**
+ * Marks a block as free and adds it to the free list of its order
+ * @param index - page index of the block
+ * @param order - order of the block
+ */
+static void kmem_block_free(int index, int order) {
+    kmem_page_t *page = &kmem_pages[index];
+
+    page->order = order;
+    page->free = 1;
+    page->cache = NULL;
+
+    list_append(&kmem_free_area[order], &page->node);
+}
+
+/**
+ * Allocates a block of pages
+ * @param order - the block is 2^order pages
+ * @return pointer to the block, NULL if no block is available
+ */
+void *kmem_page_alloc(int order) {
+    kmem_page_t *page;
+    list_node_t *node;
+    int index;
+    int o;
+
+    if (order < 0 || order >= KMEM_ORDER_MAX) {
+        kernel_log_warn("kmem: invalid order %d", order);
+        return NULL;
+    }
+
+    // Find the smallest free block that is large enough
+    for (o = order; o < KMEM_ORDER_MAX; o++) {
+        if (!list_is_empty(&kmem_free_area[o])) {
+            break;
+        }
+    }
+
+    if (o == KMEM_ORDER_MAX) {
+        kernel_log_warn("kmem: unable to allocate a block of order %d", order);
+        return NULL;
+    }
+
+    node = list_pop(&kmem_free_area[o]);
+    page = list_entry(node, kmem_page_t, node);
+    index = page - kmem_pages;
+
+    // Split the block, freeing the upper halves, until it is the requested size
+    while (o > order) {
+        o--;
+        kmem_block_free(index + (1 << o), o);
+    }
+
+    page->order = order;
+    page->free = 0;
+    page->cache = NULL;
+
+    kmem_free_count -= 1 << order;
+
+    return kmem_page_to_addr(page);
+}
+
+/**
+ * Frees a block of pages
+ * @param addr - pointer to the block
+ */
+void kmem_page_free(void *addr) {
+    kmem_page_t *page = kmem_addr_to_page(addr);
+    kmem_page_t *buddy;
+    int index;
+    int order;
+
+    if (!page || page->free || kmem_page_to_addr(page) != addr) {
+        kernel_panic("kmem: invalid block 0x%08x", (unsigned int)addr);
+        return;
+    }
+
+    index = page - kmem_pages;
+    order = page->order;
+
+    kmem_free_count += 1 << order;
+
+    // Merge with the buddy for as long as it is free
+    while (order < KMEM_ORDER_MAX - 1) {
+        int buddy_index = index ^ (1 << order);
+
+        if (buddy_index + (1 << order) > KMEM_PAGES) {
+            break;
+        }
+
+        buddy = &kmem_pages[buddy_index];
+        if (!buddy->free || buddy->order != order) {
+            break;
+        }
+
+        list_remove(&kmem_free_area[order], &buddy->node);
+        buddy->free = 0;
+
+        if (buddy_index < index) {
+            index = buddy_index;
+        }
+
+        order++;
+    }
+
+    kmem_block_free(index, order);
+}
+
+/**
+ * Looks up the descriptor of the page containing an address
+ * @param addr - address within the managed memory
+ * @return pointer to the page descriptor, NULL if not managed memory
+ */
+kmem_page_t *kmem_addr_to_page(void *addr) {
+    unsigned char *p = addr;
+
+    if (p < kmem_base || p >= kmem_base + KMEM_SIZE) {
+        return NULL;
+    }
+
+    return &kmem_pages[(p - kmem_base) >> KMEM_PAGE_SHIFT];
+}
+
+/**
+ * Returns the address of a page
+ * @param page - pointer to the page descriptor
+ * @return pointer to the start of the page
+ */
+void *kmem_page_to_addr(kmem_page_t *page) {
+    return kmem_base + ((page - kmem_pages) << KMEM_PAGE_SHIFT);
+}
+
+/**
+ * Returns the index of a page within the managed memory
+ * @param page - pointer to the page descriptor
+ * @return page index
+ */
+int kmem_page_index(kmem_page_t *page) {
+    return page - kmem_pages;
+}
+
+/**
+ * Returns the end of the managed memory
+ * @return address of the first byte above the managed memory
+ */
+void *kmem_limit(void) {
+    return kmem_base + KMEM_SIZE;
+}
+
+/**
+ * Returns the number of pages that are free
+ * @return number of free pages
+ */
+int kmem_pages_free(void) {
+    return kmem_free_count;
+}
+
+/**
+ * Reads a CMOS register
+ * @param reg - register number
+ * @return register value
+ */
+static unsigned int kmem_cmos_read(int reg) {
+    outportb(KMEM_CMOS_ADDR, reg);
+    return inportb(KMEM_CMOS_DATA);
+}
+
+/**
+ * Returns the end of the physical memory the BIOS found
+ * @return address of the first byte above physical memory, 0 if unknown
+ */
+static unsigned int kmem_detect(void) {
+    unsigned int blocks;
+    unsigned int kb;
+
+    // Memory above 16 MB, which the 1 MB count can not describe past 64 MB
+    blocks = (kmem_cmos_read(KMEM_CMOS_HIGH_HIGH) << 8) | kmem_cmos_read(KMEM_CMOS_HIGH_LOW);
+    if (blocks) {
+        return (16 * 1024 * 1024) + (blocks * 64 * 1024);
+    }
+
+    kb = (kmem_cmos_read(KMEM_CMOS_EXT_HIGH) << 8) | kmem_cmos_read(KMEM_CMOS_EXT_LOW);
+    if (kb) {
+        return (1024 * 1024) + (kb * 1024);
+    }
+
+    return 0;
+}
+
+/**
+ * Initializes the page allocator with the memory above the kernel image
+ */
+void kmem_init(void) {
+    unsigned int mem_end;
+    int index = 0;
+    int order;
+
+    kmem_base = (unsigned char *)(((unsigned int)end + KMEM_PAGE_SIZE - 1) & ~(KMEM_PAGE_SIZE - 1));
+
+    kernel_log_info("kmem: managing %d pages at 0x%08x", KMEM_PAGES, (unsigned int)kmem_base);
+
+    // The managed memory must exist
+    mem_end = kmem_detect();
+    if (mem_end == 0) {
+        kernel_log_warn("kmem: unable to detect the amount of memory");
+    } else if ((unsigned int)kmem_base + KMEM_SIZE > mem_end) {
+        kernel_panic("kmem: %d KB of memory needed up to 0x%08x, %d KB found; lower KMEM_SIZE",
+                     ((unsigned int)kmem_base + KMEM_SIZE) / 1024, (unsigned int)kmem_base + KMEM_SIZE,
+                     mem_end / 1024);
+    }
+
+    for (int i = 0; i < KMEM_ORDER_MAX; i++) {
+        list_init(&kmem_free_area[i]);
+    }
+
+    // Carve the memory into the largest blocks that fit
+    while (index < KMEM_PAGES) {
+        for (order = KMEM_ORDER_MAX - 1; order > 0; order--) {
+            if ((index & ((1 << order) - 1)) == 0 && index + (1 << order) <= KMEM_PAGES) {
+                break;
+            }
+        }
+
+        kmem_block_free(index, order);
+        index += 1 << order;
+    }
+
+    kmem_free_count = KMEM_PAGES;
+}
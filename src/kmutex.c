@@ -8,16 +8,18 @@
 
 #include <spede/string.h>
 
+#include "idtable.h"
 #include "kernel.h"
+#include "kfutex.h"
 #include "kmutex.h"
-#include "queue.h"
+#include "kslab.h"
 #include "scheduler.h"
 
-// Table of all mutexes
-mutex_t mutexes[MUTEX_MAX];
+// Mutex cache -> mutexes are allocated when they are created
+kmem_cache_t mutex_cache = KMEM_CACHE("mutex", sizeof(mutex_t), 0, KMEM_CACHE_ZERO);
 
-// Mutex ids to be allocated
-queue_t mutex_queue;
+// Table of all mutexes, indexed by mutex id; grows on demand up to MUTEX_MAX
+idtable_t mutex_table;
 
 /**
  * Initializes kernel mutex data structures
@@ -26,24 +28,219 @@ queue_t mutex_queue;
 int kmutexes_init() {
     kernel_log_info("Initializing kernel mutexes");
 
-    // Initialize the mutex table
-    for (int i=0; i<MUTEX_MAX; i++){
-        mutexes[i].allocated = 0; //set to 1 to indicate mutex allocated
-        mutexes[i].locks = 0; //initial mutex lock value should always be 0
-        mutexes[i].owner = NULL; //mutex owner should be a NULL ptr
-        kernel_log_info("Initializing wait queues in mutex");
-        queue_init(&mutexes[i].wait_queue);
-    }
-    // Initialize the mutex queue
-    queue_init(&mutex_queue);
-    // Fill the mutex queue
-    for (int i=0; i<MUTEX_MAX; i++){
-        if (queue_in(&mutex_queue, i) != 0 ){
-            kernel_log_info("Fill Mutex Queue error");
-            return -1;
+    // Mutexes are allocated from the mutex cache when they are created,
+    // and the table is allocated with the first mutex id
+    idtable_init(&mutex_table, MUTEX_TABLE_INIT, MUTEX_MAX);
+    return 0;
+}
+
+/**
+ * Looks up an allocated mutex
+ * @param id - the mutex id
+ * @return pointer to the mutex, NULL if the id is invalid or not allocated
+ */
+static mutex_t *kmutex_get(int id) {
+    mutex_t *mutex;
+
+    if (id < 0 || id >= MUTEX_MAX){
+        kernel_log_error("mutex id %d invalid range", id);
+        return NULL;
+    }
+
+    mutex = idtable_get(&mutex_table, id);
+    if (!mutex){
+        kernel_log_error("mutex id %d is not allocated", id);
+    }
+
+    return mutex;
+}
+
+/**
+ * Returns the highest priority process waiting on a mutex
+ * Waiters of the same priority are taken in the order they blocked
+ * @param mutex - pointer to the mutex
+ * @return pointer to the process, NULL if no process is waiting
+ */
+static proc_t *kmutex_waiter_top(mutex_t *mutex) {
+    proc_t *top = NULL;
+    proc_t *proc;
+
+    for (list_node_t *node = mutex->wait_queue.head; node; node = node->next) {
+        proc = list_entry(node, proc_t, scheduler_node);
+        if (!top || proc->priority < top->priority) {
+            top = proc;
         }
     }
-    return 0;
+
+    return top;
+}
+
+/**
+ * Returns the effective priority a process should run at
+ * A process runs at the priority of the highest priority process waiting
+ * on a kernel mutex or priority inheritance futex it owns, if that is
+ * higher than its own
+ * @param proc - pointer to the process
+ * @return priority level
+ */
+int kmutex_priority(proc_t *proc) {
+    int priority = proc->base_priority;
+    mutex_t *mutex;
+    proc_t *waiter;
+
+    for (list_node_t *node = proc->mutexes_held.head; node; node = node->next) {
+        mutex = list_entry(node, mutex_t, owner_node);
+
+        waiter = kmutex_waiter_top(mutex);
+        if (waiter && waiter->priority < priority) {
+            priority = waiter->priority;
+        }
+    }
+
+    waiter = kfutex_waiter_top(proc);
+    if (waiter && waiter->priority < priority) {
+        priority = waiter->priority;
+    }
+
+    return priority;
+}
+
+/**
+ * Returns the owner of the lock a process is waiting on
+ * @param proc - pointer to the process
+ * @return pointer to the owner, NULL if the process is not waiting on a
+ *         kernel mutex or priority inheritance futex
+ */
+static proc_t *kmutex_blocker(proc_t *proc) {
+    if (proc->mutex_wait) {
+        return proc->mutex_wait->owner;
+    }
+
+    if (proc->futex_owner) {
+        return pid_to_proc(proc->futex_owner);
+    }
+
+    return NULL;
+}
+
+/**
+ * Sets the owner of a mutex
+ * The mutex moves from the previous owner's list of held mutexes to the
+ * new owner's
+ * @param mutex - pointer to the mutex
+ * @param proc - pointer to the new owner, NULL if the mutex is released
+ */
+static void kmutex_set_owner(mutex_t *mutex, proc_t *proc) {
+    if (mutex->owner) {
+        list_remove(&mutex->owner->mutexes_held, &mutex->owner_node);
+    }
+
+    mutex->owner = proc;
+
+    if (proc) {
+        list_append(&proc->mutexes_held, &mutex->owner_node);
+    }
+}
+
+/**
+ * Raises the effective priority of a lock owner to a waiter's priority
+ * If the owner is itself waiting on a kernel mutex or priority inheritance
+ * futex, the priority is passed along the chain of owners
+ * @param owner - pointer to the owner of the lock being waited on
+ * @param priority - priority of the waiter
+ */
+void kmutex_inherit(proc_t *owner, int priority) {
+    // A chain can not be longer than the number of processes; the bound
+    // also stops at a deadlock cycle
+    for (int depth = 0; owner && depth < PROC_MAX; depth++) {
+        if (owner->priority <= priority) {
+            break;
+        }
+
+        kernel_log_trace("mutex: pid=%d inherits priority %d", owner->pid, priority);
+        scheduler_set_effective_priority(owner, priority);
+
+        owner = kmutex_blocker(owner);
+    }
+}
+
+/**
+ * Recomputes the effective priority of a lock owner after a waiter left
+ * The change is passed along the chain of owners
+ * @param owner - pointer to the owner of the lock the waiter left
+ */
+void kmutex_update(proc_t *owner) {
+    int priority;
+
+    for (int depth = 0; owner && depth < PROC_MAX; depth++) {
+        priority = kmutex_priority(owner);
+        if (priority == owner->priority) {
+            break;
+        }
+
+        scheduler_set_effective_priority(owner, priority);
+
+        owner = kmutex_blocker(owner);
+    }
+}
+
+/**
+ * Passes a mutex to the highest priority process waiting on it
+ * The process is added back to the scheduler and inherits from the
+ * processes still waiting; without waiters the mutex has no owner
+ * @param mutex - pointer to the mutex
+ * @return pointer to the new owner, NULL if no process was waiting
+ */
+static proc_t *kmutex_pass(mutex_t *mutex) {
+    proc_t *proc = kmutex_waiter_top(mutex);
+
+    kmutex_set_owner(mutex, proc);
+
+    if (proc) {
+        scheduler_remove(proc);
+        proc->mutex_wait = NULL;
+        scheduler_add(proc);
+
+        scheduler_set_effective_priority(proc, kmutex_priority(proc));
+    }
+
+    return proc;
+}
+
+/**
+ * Releases the mutexes of a process that is exiting
+ * The process stops waiting on a mutex, and each mutex it owns is passed
+ * to the highest priority process waiting on it
+ * @param proc - pointer to the process
+ */
+void kmutex_release(proc_t *proc) {
+    mutex_t *mutex;
+
+    if (!proc) {
+        return;
+    }
+
+    mutex = proc->mutex_wait;
+    if (mutex) {
+        if (proc->scheduler_queue == &mutex->wait_queue) {
+            scheduler_remove(proc);
+        }
+
+        proc->mutex_wait = NULL;
+        mutex->locks--;
+
+        // The owner no longer inherits the process' priority
+        kmutex_update(mutex->owner);
+    }
+
+    while (proc->mutexes_held.head) {
+        mutex = list_entry(proc->mutexes_held.head, mutex_t, owner_node);
+
+        kernel_log_warn("mutex: process %d exited holding a mutex", proc->pid);
+
+        mutex->locks--;
+        kmutex_pass(mutex);
+    }
 }
 
 /**
@@ -51,26 +248,26 @@ int kmutexes_init() {
  * @return -1 on error, otherwise the mutex id that was allocated
  */
 int kmutex_init(void) {
-    // Obtain a mutex id from the mutex queue
     int id;
-    queue_out(&mutex_queue, &id);
-    // Ensure that the id is within the valid range
-    if (id > MUTEX_MAX){
-        kernel_log_error("kmutex_init: mutex id %d invalid range", id);
+    // Allocate the mutex; it is handed out clear (unlocked, no owner)
+    mutex_t *mutex_entry_ptr = kmem_cache_alloc(&mutex_cache);
+    if (!mutex_entry_ptr){
+        kernel_log_error("kmutex_init: unable to allocate a mutex");
         return -1;
     }
-    // Pointer to the mutex table entry
-    mutex_t *mutex_entry_ptr = &mutexes[id];
     // Initialize the mutex data structure (mutex_t + all members)
-    if (mutex_entry_ptr){
-        mutex_entry_ptr->allocated = 1;
-        //mutex_t members should be initialized already from kmutexes_int()
-        return id;
-    }
-    // return the mutex id
-    else{
+    list_init(&mutex_entry_ptr->wait_queue);
+    mutex_entry_ptr->allocated = 1;
+    // Bind the mutex to a mutex id
+    id = idtable_alloc(&mutex_table, mutex_entry_ptr);
+    if (id < 0){
+        kernel_log_error("kmutex_init: no mutex ids available");
+        memset(mutex_entry_ptr, 0, sizeof(mutex_t));
+        kmem_cache_free(&mutex_cache, mutex_entry_ptr);
         return -1;
     }
+    // return the mutex id
+    return id;
 }
 
 /**
@@ -80,20 +277,21 @@ int kmutex_init(void) {
  */
 int kmutex_destroy(int id) {
     // look up the mutex in the mutex table
-    mutex_t *mutex_ptr = &mutexes[id];
+    mutex_t *mutex_ptr = kmutex_get(id);
     if (mutex_ptr){
         if (mutex_ptr->locks > 0){
             kernel_log_error("Cannot destroy locked mutex ");
             return -1; //error
         }
 
-        // Add the id back into the mutex queue to be re-used later
-        if (queue_in(&mutex_queue, id) != 0){
-            kernel_log_error("error adding id back into mutex queue ");
+        // Free the id to be re-used later
+        if (idtable_free(&mutex_table, id) != 0){
+            kernel_log_error("error freeing the mutex id");
             return -1;
         }
-        // Clear the memory for the data structure
+        // Clear the memory for the data structure and return it to the cache
         memset(mutex_ptr, 0, sizeof(mutex_t));
+        kmem_cache_free(&mutex_cache, mutex_ptr);
         kernel_log_info("Mutex cleared/destroyed");
         return 0;
     }
@@ -108,7 +306,7 @@ int kmutex_destroy(int id) {
  */
 int kmutex_lock(int id) {
     // look up the mutex in the mutex table
-    mutex_t *mutex_ptr = &mutexes[id];
+    mutex_t *mutex_ptr = kmutex_get(id);
     proc_t *proc = active_proc;
     if (!proc){
         kernel_panic("Invalid process - called from kmutex_lock()");
@@ -121,18 +319,17 @@ int kmutex_lock(int id) {
         //      the mutex when it is unlocked)
         //   3. Remove the process from the scheduler, allow another
         //      process to be scheduled
+        //   4. Lend the process' priority to the owner so it is not
+        //      preempted by processes of lower priority than the waiter
         if (mutex_ptr->locks > 0){
-            scheduler_remove(proc);
-
-            proc->state = WAITING;
-            proc->scheduler_queue = &mutex_ptr->wait_queue;
-            queue_in(&mutex_ptr->wait_queue, proc->pid);
-            
+            scheduler_wait(proc, &mutex_ptr->wait_queue);
+            proc->mutex_wait = mutex_ptr;
+            kmutex_inherit(mutex_ptr->owner, proc->priority);
         }
         // If the mutex is not locked
         //   1. set the mutex owner to the active process
         if (mutex_ptr->locks == 0){
-            mutex_ptr->owner = proc;
+            kmutex_set_owner(mutex_ptr, proc);
         }
         // Increment the lock count
         (mutex_ptr->locks)++;
@@ -149,9 +346,12 @@ int kmutex_lock(int id) {
  */
 int kmutex_unlock(int id) {
     proc_t *proc;
-    int temp_id;
+    proc_t *owner;
     // look up the mutex in the mutex table
-    mutex_t *mutex_ptr = &mutexes[id];
+    mutex_t *mutex_ptr = kmutex_get(id);
+    if (!mutex_ptr){
+        return -1;
+    }
     // If the mutex is not locked, there is nothing to do
     if (mutex_ptr->locks == 0){
         kernel_log_info("mutex is not locked, nothing to do");
@@ -159,26 +359,35 @@ int kmutex_unlock(int id) {
     }
     // Decrement the lock count
     (mutex_ptr->locks)--;
+    owner = mutex_ptr->owner;
     // If there are no more locks held:
     //    1. clear the owner of the mutex
+    //    2. drop the previous owner's inherited priority
     if (mutex_ptr->locks == 0){
-        mutex_ptr->owner = NULL;
+        kmutex_set_owner(mutex_ptr, NULL);
+        if (owner) {
+            scheduler_set_effective_priority(owner, kmutex_priority(owner));
+        }
         return mutex_ptr->locks;
     }
     // If there are still locks held:
-    //    1. Obtain a process from the mutex wait queue
+    //    1. Obtain the highest priority process from the mutex wait queue
     //    2. Add the process back to the scheduler
-    //    3. set the owner of the of the mutex to the process
+    //    3. set the owner of the of the mutex to the process; it inherits
+    //       from the processes still waiting
+    //    4. drop the previous owner's inherited priority
     else {
-        // 1.
-        queue_out(&mutex_ptr->wait_queue, &temp_id);
-        proc = pid_to_proc(temp_id);
+        // 1. + 2. + 3.
+        proc = kmutex_pass(mutex_ptr);
+        // 4.
+        if (owner) {
+            scheduler_set_effective_priority(owner, kmutex_priority(owner));
+        }
         if (proc){
-            // 2.
-            scheduler_remove(proc);
-            scheduler_add(proc);
-            // 3.
-            mutex_ptr->owner = proc;
+#if SCHEDULER_HANDOFF
+            // Switch directly to the new owner
+            scheduler_handoff(proc);
+#endif
         }
         return mutex_ptr->locks;
     }
@@ -0,0 +1,187 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Pipes
+ *
+ * A pipe is a ring buffer bound into IO slots of the processes using it,
+ * each slot as either its read end or its write end. The ring buffer
+ * counts the ends of each kind: readers see the end of the pipe once the
+ * last write end is closed, writers fail once the last read end is
+ * closed, and the buffer is released with the last end. Blocking reads
+ * and writes are handled by the IO system calls.
+ */
+
+#include "kernel.h"
+#include "kpipe.h"
+#include "scheduler.h"
+
+/**
+ * Takes a reference on a pipe for an end
+ * @param buf - pointer to the pipe's ring buffer
+ * @param end - PROC_PIPE_READ or PROC_PIPE_WRITE
+ */
+static void kpipe_ref(ringbuf_t *buf, int end) {
+    if (end == PROC_PIPE_READ) {
+        buf->read_ends++;
+    } else {
+        buf->write_ends++;
+    }
+}
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of a process
+ * Reading from the read end blocks while the pipe is empty and returns 0
+ * once it is empty with no write ends left; writing to the write end
+ * blocks while the pipe is full and fails with no read ends left
+ * @param proc - process creating the pipe
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return 0 on success, -1 on error
+ */
+int kpipe_create(proc_t *proc, int *ends, int size) {
+    ringbuf_t *buf;
+    int slots[2];
+    int found = 0;
+
+    if (!proc || !ends || size < 0 || size > RINGBUF_SIZE) {
+        return -1;
+    }
+
+    for (int i = 0; i < PROC_IO_MAX && found < 2; i++) {
+        if (!proc->io[i]) {
+            slots[found++] = i;
+        }
+    }
+
+    if (found < 2) {
+        kernel_log_warn("pipe: process %d has no free IO slots", proc->pid);
+        return -1;
+    }
+
+    buf = ringbuf_alloc();
+    if (!buf) {
+        kernel_log_warn("pipe: unable to allocate a buffer");
+        return -1;
+    }
+
+    if (size > 0) {
+        buf->capacity = size;
+    }
+
+    proc->io[slots[0]] = buf;
+    proc->io_pipe[slots[0]] = PROC_PIPE_READ;
+    kpipe_ref(buf, PROC_PIPE_READ);
+
+    proc->io[slots[1]] = buf;
+    proc->io_pipe[slots[1]] = PROC_PIPE_WRITE;
+    kpipe_ref(buf, PROC_PIPE_WRITE);
+
+    ends[0] = slots[0];
+    ends[1] = slots[1];
+
+    kernel_log_debug("pipe: process %d created a %d byte pipe (io %d, %d)", proc->pid,
+                     buf->capacity, slots[0], slots[1]);
+
+    return 0;
+}
+
+/**
+ * Closes an IO slot of a process
+ * A pipe is released when its last end is closed
+ * @param proc - process closing the slot
+ * @param io - the IO id
+ * @return 0 on success, -1 on error
+ */
+int kpipe_close(proc_t *proc, int io) {
+    ringbuf_t *buf;
+    int end;
+
+    if (!proc || io < 0 || io >= PROC_IO_MAX || !proc->io[io]) {
+        return -1;
+    }
+
+    buf = proc->io[io];
+    end = proc->io_pipe[io];
+
+    proc->io[io] = NULL;
+    proc->io_pipe[io] = 0;
+
+    if (!end) {
+        return 0;
+    }
+
+    // Readers blocked on an empty pipe see its end once the last write
+    // end is closed; writers blocked on a full pipe fail once the last
+    // read end is closed
+    if (end == PROC_PIPE_READ) {
+        buf->read_ends--;
+        if (buf->read_ends == 0) {
+            while (scheduler_wake(&buf->writers));
+        }
+    } else {
+        buf->write_ends--;
+        if (buf->write_ends == 0) {
+            while (scheduler_wake(&buf->readers));
+        }
+    }
+
+    // Processes blocked on the pipe hold an end of it, so none are waiting
+    if (buf->read_ends == 0 && buf->write_ends == 0) {
+        ringbuf_free(buf);
+    }
+
+    return 0;
+}
+
+/**
+ * Binds a process' IO buffer into the same IO slot of another process
+ * A pipe end takes a reference on the pipe
+ * @param parent - process holding the IO buffer
+ * @param child - process receiving the IO buffer
+ * @param io - the IO id
+ */
+void kpipe_dup(proc_t *parent, proc_t *child, int io) {
+    if (!parent || !child || io < 0 || io >= PROC_IO_MAX) {
+        return;
+    }
+
+    // Whatever the slot held is replaced
+    if (child->io[io]) {
+        kpipe_close(child, io);
+    }
+
+    child->io[io] = parent->io[io];
+    child->io_pipe[io] = parent->io_pipe[io];
+
+    if (child->io_pipe[io]) {
+        kpipe_ref(child->io[io], child->io_pipe[io]);
+    }
+}
+
+/**
+ * Passes the pipe ends of a process to another process
+ * The ends are bound to the same IO ids in the other process
+ * @param parent - process holding the pipe ends
+ * @param child - process receiving the pipe ends
+ */
+void kpipe_fork(proc_t *parent, proc_t *child) {
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        if (parent->io_pipe[i]) {
+            kpipe_dup(parent, child, i);
+        }
+    }
+}
+
+/**
+ * Closes all of the pipe ends a process holds
+ * @param proc - process to release
+ */
+void kpipe_release(proc_t *proc) {
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        if (proc->io_pipe[i]) {
+            kpipe_close(proc, i);
+        }
+    }
+}
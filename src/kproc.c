@@ -11,26 +11,149 @@
 #include <spede/machine/proc_reg.h>
 
 #include "kernel.h"
+#include "kfpu.h"
+#include "kfutex.h"
+#include "kmutex.h"
+#include "kpipe.h"
+#include "kshm.h"
+#include "kslab.h"
+#include "kvm.h"
 #include "trapframe.h"
 #include "kproc.h"
 #include "scheduler.h"
 #include "timer.h"
-#include "queue.h"
+#include "tsc.h"
 #include "vga.h"
 #include "prog_user.h"
 #include "syscall_common.h"
 
-// Next available process id to be assigned
-int next_pid;
+// Process table entry
+typedef struct proc_entry_t {
+    proc_t *proc;                   // Process using the entry, NULL if the entry is free
+    int generation;                 // Generation of the entry; part of the process id
+    int next_free;                  // Next free entry while the entry is free, -1 at the end
+} proc_entry_t;
 
-// Process table allocator
-queue_t proc_allocator;
+// Process table; grows on demand up to PROC_MAX entries
+proc_entry_t *proc_table;
+int proc_table_size;
 
-// Process table
-proc_t proc_table[PROC_MAX];
+// Process table allocator -> stack of free entries linked through the
+// table; the most recently freed entry is reused first
+int proc_free_head = -1;
 
-// Process stacks
-unsigned char proc_stack[PROC_MAX][PROC_STACK_SIZE];
+// All processes, in the order they were created
+list_t proc_list;
+
+// The hot fields of the process control block must fit its first cache line
+typedef char proc_hot_fits[__builtin_offsetof(proc_t, feedback_level) + sizeof(int) <= PROC_CACHE_LINE ? 1 : -1];
+
+// Process control block cache
+// The control block size is a multiple of the cache line, so control
+// blocks in a slab stay cache line aligned
+kmem_cache_t proc_cache = KMEM_CACHE("proc", sizeof(proc_t), 0, KMEM_CACHE_ZERO);
+
+// Process stack cache
+// Stacks are handed out clear and must be cleared before they are freed
+kmem_cache_t proc_stack_cache = KMEM_CACHE("proc_stack", PROC_STACK_SIZE, 3, KMEM_CACHE_ZERO);
+
+// Process template -> a process control block with its address space,
+// stack and initial trapframe already set up
+typedef struct proc_template_t {
+    proc_t *proc;                   // Process control block
+    trapframe_t *trapframe;         // Initial trapframe, as the kernel can write it
+} proc_template_t;
+
+// Process template pool; refilled from the timer so creating a process
+// only has to take a template and fill in the entry point
+proc_template_t proc_pool[PROC_POOL_SIZE];
+int proc_pool_count;
+
+// Number of processes created from the pool and without it
+int proc_pool_hits;
+int proc_pool_misses;
+
+// Number of processes forked and the CPU cycles spent forking them
+int proc_forks;
+unsigned long long proc_fork_cycles;
+
+/**
+ * Measures how much of a process stack has been used
+ * Stacks start out clear and grow down, so the deepest point the stack
+ * reached is the lowest non-zero word
+ * @param stack - pointer to the process stack
+ * @return number of bytes at the top of the stack that may be non-zero
+ */
+static int kproc_stack_used(unsigned char *stack) {
+    unsigned int *word = (unsigned int *)stack;
+    unsigned int *top = (unsigned int *)(stack + PROC_STACK_SIZE);
+
+    while (word < top && *word == 0) {
+        word++;
+    }
+
+    return (unsigned char *)top - (unsigned char *)word;
+}
+
+/**
+ * Returns the smallest page block order that holds a number of bytes
+ * @param size - number of bytes
+ * @return page block order
+ */
+static int kproc_table_order(int size) {
+    int order = 0;
+
+    while ((KMEM_PAGE_SIZE << order) < size) {
+        order++;
+    }
+
+    return order;
+}
+
+/**
+ * Grows the process table
+ * The table doubles in size, up to PROC_MAX entries. The new entries are
+ * added to the allocator so the lowest ones are used first.
+ * @return 0 on success, -1 if the table can not grow
+ */
+static int kproc_table_grow(void) {
+    proc_entry_t *table;
+    int size;
+
+    if (proc_table_size >= PROC_MAX) {
+        return -1;
+    }
+
+    size = proc_table_size ? proc_table_size * 2 : PROC_TABLE_INIT;
+    if (size > PROC_MAX) {
+        size = PROC_MAX;
+    }
+
+    table = kmem_page_alloc(kproc_table_order(size * sizeof(proc_entry_t)));
+    if (!table) {
+        return -1;
+    }
+
+    // Move the existing entries; the rest of the table starts out free
+    if (proc_table) {
+        memcpy(table, proc_table, proc_table_size * sizeof(proc_entry_t));
+        kmem_page_free(proc_table);
+    }
+
+    for (int i = size - 1; i >= proc_table_size; i--) {
+        table[i].proc = NULL;
+        table[i].generation = 0;
+        table[i].next_free = proc_free_head;
+        proc_free_head = i;
+    }
+
+    kernel_log_debug("Process table grew from %d to %d entries", proc_table_size, size);
+
+    proc_table = table;
+    proc_table_size = size;
+
+    return 0;
+}
 
 /**
  * Looks up a process in the process table via the process id
@@ -38,13 +161,21 @@ unsigned char proc_stack[PROC_MAX][PROC_STACK_SIZE];
  * @return pointer to the pruocess entry, NULL or error or if not found
  */
 proc_t *pid_to_proc(int pid) {
-    for (unsigned int i = 0; i < PROC_MAX; i++) {
-        if (proc_table[i].pid == pid) {
-            return &proc_table[i];
-        }
+    proc_t *proc;
+
+    if (pid < 0) {
+        return NULL;
     }
 
-    return NULL;
+    // The entry is encoded in the process id
+    proc = entry_to_proc(pid & PROC_PID_ENTRY_MASK);
+
+    // Reject process ids from a previous use of the entry
+    if (!proc || proc->state == NONE || proc->pid != pid) {
+        return NULL;
+    }
+
+    return proc;
 }
 
 /**
@@ -53,30 +184,164 @@ proc_t *pid_to_proc(int pid) {
  * @return the index into the process table, -1 on error
  */
 int proc_to_entry(proc_t *proc) {
-    if (proc == NULL) {
+    int entry;
+
+    if (!proc) {
         return -1;
     }
 
-    for (unsigned int i = 0; i < PROC_MAX; i++) {
-        if (proc->pid == proc_table[i].pid) {
-            return i;
-        }
+    // The entry is encoded in the process id
+    entry = proc->pid & PROC_PID_ENTRY_MASK;
+    if (entry >= proc_table_size || proc_table[entry].proc != proc) {
+        return -1;
     }
 
-    return -1;
+    return entry;
 }
 
 /**
  * Returns a pointer to the given process entry
+ * @param entry - entry/index value
+ * @return pointer to the process entry, NULL if the entry is not in use
  */
 proc_t * entry_to_proc(int entry) {
-    if (entry >= 0 && entry < PROC_MAX) {
-        return &proc_table[entry];
+    if (entry >= 0 && entry < proc_table_size) {
+        return proc_table[entry].proc;
     }
 
     return NULL;
 }
 
+/**
+ * Returns the first process in the list of all processes
+ * Processes are listed in the order they were created
+ * @return pointer to the process entry, NULL if there are no processes
+ */
+proc_t *proc_list_first(void) {
+    if (!proc_list.head) {
+        return NULL;
+    }
+
+    return list_entry(proc_list.head, proc_t, proc_node);
+}
+
+/**
+ * Returns the process after the given one in the list of all processes
+ * @param proc - pointer to the process entry
+ * @return pointer to the process entry, NULL at the end of the list
+ */
+proc_t *proc_list_next(proc_t *proc) {
+    if (!proc || !proc->proc_node.next) {
+        return NULL;
+    }
+
+    return list_entry(proc->proc_node.next, proc_t, proc_node);
+}
+
+/**
+ * Returns the number of processes
+ * @return number of processes
+ */
+int proc_count(void) {
+    return proc_list.size;
+}
+
+/**
+ * Builds a process template
+ * Allocates the process control block, address space and stack, and sets
+ * up everything in the initial trapframe except the entry point
+ * @param template - template to fill in
+ * @return 0 on success, -1 if no memory is available
+ */
+static int kproc_template_build(proc_template_t *template) {
+    proc_t *proc;
+    unsigned char *stack_top;
+
+    // Allocate the process control block
+    // It is handed out clear, as are the stacks
+    proc = kmem_cache_alloc(&proc_cache);
+    if (!proc) {
+        kernel_log_warn("Unable to allocate a process control block");
+        return -1;
+    }
+
+    // Create the process' address space
+    // With paging, the stack is mapped in the address space and backed
+    // by zero pages as it is first touched; otherwise a stack is allocated
+    if (kvm_enabled()) {
+        proc->page_dir = kvm_dir_create();
+        if (!proc->page_dir) {
+            kernel_log_warn("Unable to allocate a process address space");
+            kmem_cache_free(&proc_cache, proc);
+            return -1;
+        }
+
+        stack_top = kvm_stack_create(proc->page_dir);
+        if (!stack_top) {
+            kernel_log_warn("Unable to allocate a process stack");
+            kvm_dir_destroy(proc->page_dir);
+            proc->page_dir = NULL;
+            kmem_cache_free(&proc_cache, proc);
+            return -1;
+        }
+
+        // The trapframe is written through the page's physical address
+        // since the address space is not loaded
+        template->trapframe = (trapframe_t *)(stack_top + KMEM_PAGE_SIZE - sizeof(trapframe_t));
+        proc->trapframe = (trapframe_t *)(KVM_STACK_TOP - sizeof(trapframe_t));
+    } else {
+        proc->stack = kmem_cache_alloc(&proc_stack_cache);
+        if (!proc->stack) {
+            kernel_log_warn("Unable to allocate a process stack");
+            kmem_cache_free(&proc_cache, proc);
+            return -1;
+        }
+
+        template->trapframe = (trapframe_t *)(&proc->stack[PROC_STACK_SIZE - sizeof(trapframe_t)]);
+        proc->trapframe = template->trapframe;
+    }
+
+    // Set INTR flag
+    template->trapframe->eflags = EF_DEFAULT_VALUE | EF_INTR;
+
+    // Set each segment in the trapframe
+    template->trapframe->cs = get_cs();
+    template->trapframe->ds = get_ds();
+    template->trapframe->es = get_es();
+    template->trapframe->fs = get_fs();
+    template->trapframe->gs = get_gs();
+
+    template->proc = proc;
+
+    return 0;
+}
+
+/**
+ * Refills the process template pool
+ */
+static void kproc_pool_fill(void) {
+    while (proc_pool_count < PROC_POOL_SIZE) {
+        if (kproc_template_build(&proc_pool[proc_pool_count]) != 0) {
+            break;
+        }
+
+        proc_pool_count++;
+    }
+}
+
+/**
+ * Prints the process creation statistics to the kernel log
+ */
+void kproc_dump(void) {
+    kernel_log_info("kproc: %d of %d templates ready, %d processes created from the pool, %d without",
+                    proc_pool_count, PROC_POOL_SIZE, proc_pool_hits, proc_pool_misses);
+
+    if (proc_forks > 0) {
+        kernel_log_info("kproc: %d forks, %d cycles each, %d pages copied per fork", proc_forks,
+                        (int)(proc_fork_cycles / proc_forks), kvm_pages_copied() / proc_forks);
+    }
+}
+
 /**
  * Creates a new process
  * @param proc_ptr - address of process to execute
@@ -85,6 +350,7 @@ proc_t * entry_to_proc(int entry) {
  * @return process id of the created process, -1 on error
  */
 int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
+    proc_template_t template;
     int proc_entry;
     proc_t *proc;
 
@@ -98,25 +364,35 @@ int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
     }
 
     // Allocate the PCB entry for the process
-    if (queue_out(&proc_allocator, &proc_entry) != 0) {
+    // Grow the process table if every entry is in use
+    if (proc_free_head < 0 && kproc_table_grow() != 0) {
         kernel_log_warn("Unable to allocate a process entry");
         return -1;
     }
 
-    // Allocate the process table entry
-    proc = &proc_table[proc_entry];
+    // Take a template from the pool, or build one if the pool is empty
+    if (proc_pool_count > 0) {
+        template = proc_pool[--proc_pool_count];
+        proc_pool_hits++;
+    } else if (kproc_template_build(&template) == 0) {
+        proc_pool_misses++;
+    } else {
+        return -1;
+    }
 
-    // Initialize the PCB entry for the process
-    memset(proc, 0, sizeof(proc_t));
+    proc = template.proc;
 
-    // Point the stack to the process stack
-    proc->stack = proc_stack[proc_entry];
+    proc_entry = proc_free_head;
+    proc_free_head = proc_table[proc_entry].next_free;
+    proc_table[proc_entry].proc = proc;
 
     // Set the process state to RUNNING
     // Initialize other process control block variables to default values
-    proc->pid         = next_pid++;
+    proc->pid         = (proc_table[proc_entry].generation << PROC_PID_ENTRY_BITS) | proc_entry;
     proc->state       = IDLE;
     proc->type        = proc_type;
+    proc->priority    = PROC_PRIORITY_DEFAULT;
+    proc->base_priority = PROC_PRIORITY_DEFAULT;
     proc->run_time    = 0;
     proc->cpu_time    = 0;
     proc->start_time  = timer_get_ticks();
@@ -124,29 +400,110 @@ int kproc_create(void *proc_ptr, char *proc_name, proc_type_t proc_type) {
     // Copy the process name to the PCB
     strncpy(proc->name, proc_name, PROC_NAME_LEN);
 
-    // Ensure the stack for the process is cleared
-    memset(proc->stack, 0, PROC_STACK_SIZE);
-
-    // Allocate the trapframe data
-    proc->trapframe = (trapframe_t *)(&proc->stack[PROC_STACK_SIZE - sizeof(trapframe_t)]);
+    list_append(&proc_list, &proc->proc_node);
 
     // Set the instruction pointer in the trapframe
-    proc->trapframe->eip = (unsigned int)proc_ptr;
+    template.trapframe->eip = (unsigned int)proc_ptr;
 
-    // Set INTR flag
-    proc->trapframe->eflags = EF_DEFAULT_VALUE | EF_INTR;
+    // Add the process to the run queue
+    scheduler_add(proc);
 
-    // Set each segment in the trapframe
-    proc->trapframe->cs = get_cs();
-    proc->trapframe->ds = get_ds();
-    proc->trapframe->es = get_es();
-    proc->trapframe->fs = get_fs();
-    proc->trapframe->gs = get_gs();
+    kernel_log_debug("Created process %s (%d) entry=%d", proc->name, proc->pid, proc_entry);
+
+    return proc->pid;
+}
+
+/**
+ * Creates a copy of a process
+ * The copy shares the parent's pages copy-on-write, its I/O buffers and
+ * its priority, and resumes from the same point with 0 as the result of
+ * the system call
+ * Only the pages the process' address space owns (its stack) are copied;
+ * globals live in the kernel image, which every address space maps, so
+ * the copy shares them with the parent and sees the parent's writes
+ * @param parent - process to copy; must be making a system call
+ * @return process id of the copy, -1 on error
+ */
+int kproc_fork(proc_t *parent) {
+    unsigned long long start = tsc_read();
+    unsigned char *page;
+    trapframe_t *trapframe;
+    int proc_entry;
+    proc_t *proc;
+
+    if (!parent || !parent->page_dir) {
+        kernel_log_warn("Fork requires paging");
+        return -1;
+    }
+
+    if (proc_free_head < 0 && kproc_table_grow() != 0) {
+        kernel_log_warn("Unable to allocate a process entry");
+        return -1;
+    }
+
+    proc = kmem_cache_alloc(&proc_cache);
+    if (!proc) {
+        kernel_log_warn("Unable to allocate a process control block");
+        return -1;
+    }
+
+    proc->page_dir = kvm_dir_clone(parent->page_dir);
+    if (!proc->page_dir) {
+        kernel_log_warn("Unable to copy the process address space");
+        kmem_cache_free(&proc_cache, proc);
+        return -1;
+    }
+
+    // The child's trapframe is at the same address as the parent's; it
+    // gets its own copy of the page now since the kernel writes to it
+    trapframe = parent->trapframe;
+    page = kvm_cow_break(proc->page_dir, (unsigned int)&trapframe->eax);
+    if (!page) {
+        kernel_log_warn("Unable to copy the process trapframe");
+        kvm_dir_destroy(proc->page_dir);
+        proc->page_dir = NULL;
+        kmem_cache_free(&proc_cache, proc);
+        return -1;
+    }
+
+    *(unsigned int *)(page + ((unsigned int)&trapframe->eax & (KMEM_PAGE_SIZE - 1))) = 0;
+
+    if (kfpu_fork(parent, proc) != 0) {
+        kernel_log_warn("Unable to copy the process FPU state");
+        kvm_dir_destroy(proc->page_dir);
+        proc->page_dir = NULL;
+        kmem_cache_free(&proc_cache, proc);
+        return -1;
+    }
+
+    proc_entry = proc_free_head;
+    proc_free_head = proc_table[proc_entry].next_free;
+    proc_table[proc_entry].proc = proc;
+
+    proc->pid         = (proc_table[proc_entry].generation << PROC_PID_ENTRY_BITS) | proc_entry;
+    proc->state       = IDLE;
+    proc->type        = parent->type;
+    proc->priority    = parent->base_priority;
+    proc->base_priority = parent->base_priority;
+    proc->start_time  = timer_get_ticks();
+    proc->trapframe   = trapframe;
+
+    memcpy(proc->name, parent->name, PROC_NAME_LEN);
+    for (int i = 0; i < PROC_IO_MAX; i++) {
+        kpipe_dup(parent, proc, i);
+    }
+
+    // The copied address space already maps the parent's shared memory
+    kshm_fork(parent, proc);
+
+    list_append(&proc_list, &proc->proc_node);
 
-    // Add the process to the run queue
     scheduler_add(proc);
 
-    kernel_log_info("Created process %s (%d) entry=%d", proc->name, proc->pid, proc_entry);
+    proc_forks++;
+    proc_fork_cycles += tsc_read() - start;
+
+    kernel_log_debug("Forked process %s (%d) from %d entry=%d", proc->name, proc->pid, parent->pid, proc_entry);
 
     return proc->pid;
 }
@@ -168,8 +525,9 @@ int kproc_destroy(proc_t *proc) {
         return -1;
     }
 
-    // Remove the process from the scheduler
+    // Remove the process from the scheduler and release any reservation
     scheduler_remove(proc);
+    scheduler_set_periodic(proc, 0, 0);
 
     // Clean up the process table for the process
     int entry = proc_to_entry(proc);
@@ -177,19 +535,42 @@ int kproc_destroy(proc_t *proc) {
         kernel_panic("Error obtaining the process table entry");
     }
 
-    kernel_log_info("Destroying process %s (%d) entry=%d", proc->name, proc->pid, entry);
+    kernel_log_debug("Destroying process %s (%d) entry=%d", proc->name, proc->pid, entry);
 
-    // Reset the process stack
-    memset(proc->stack, 0, PROC_STACK_SIZE);
+    // Clear the part of the stack the process used and return it to the cache
+    // A stack mapped in the address space is released with it
+    unsigned char *stack = proc->stack;
 
-    // Reset the process control block
-    memset(proc, 0, sizeof(proc_t));
+    if (stack) {
+        int used = kproc_stack_used(stack);
 
-    // Add the entry back to the process queue (to be recycled)
-    if (queue_in(&proc_allocator, entry) != 0) {
-        kernel_log_warn("Unable to queue entry back into allocator");
+        memset(&stack[PROC_STACK_SIZE - used], 0, used);
+        kmem_cache_free(&proc_stack_cache, stack);
     }
 
+    kfpu_release(proc);
+    kpipe_release(proc);
+    kmutex_release(proc);
+    kfutex_release(proc);
+
+    // Detach from shared memory, then release the process' address space
+    // and the pages it owns
+    kshm_release(proc);
+    kvm_dir_destroy(proc->page_dir);
+
+    // Reset the process control block and return it to the cache
+    list_remove(&proc_list, &proc->proc_node);
+    memset(proc, 0, sizeof(proc_t));
+    kmem_cache_free(&proc_cache, proc);
+
+    // Advance the generation so the old process id is no longer valid
+    proc_table[entry].generation = (proc_table[entry].generation + 1) & PROC_PID_GEN_MASK;
+
+    // Add the entry back to the allocator (to be recycled)
+    proc_table[entry].proc = NULL;
+    proc_table[entry].next_free = proc_free_head;
+    proc_free_head = entry;
+
     return 0;
 }
 
@@ -226,8 +607,13 @@ int kproc_attach_tty(int pid, int tty_number) {
 
     if (proc && tty) {
         kernel_log_debug("Attaching PID %d to TTY id %d", proc->pid, tty_number);
-        proc->io[PROC_IO_IN] = &tty->io_input;
-        proc->io[PROC_IO_OUT] = &tty->io_output;
+
+        // Pipe ends bound to the slots are closed
+        kpipe_close(proc, PROC_IO_IN);
+        kpipe_close(proc, PROC_IO_OUT);
+
+        proc->io[PROC_IO_IN] = tty->io_input;
+        proc->io[PROC_IO_OUT] = tty->io_output;
         return 0;
     }
 
@@ -244,19 +630,17 @@ void kproc_init(void) {
 
     kernel_log_info("Initializing process management");
 
-    // Initialize the process queue
-    queue_init(&proc_allocator);
+    // Allocate the initial process table
+    // Process control blocks and stacks are allocated from their caches
+    list_init(&proc_list);
 
-    // Populate the process queue
-    for (int i = 0; i < PROC_MAX; i++) {
-        queue_in(&proc_allocator, i);
+    if (kproc_table_grow() != 0) {
+        kernel_panic("Unable to allocate the process table");
     }
 
-    // Initialize the process table
-    memset(&proc_table, 0, sizeof(proc_table));
-
-    // Initialize the process stacks
-    memset(proc_stack, 0, sizeof(proc_stack));
+    // Build the process templates, and keep the pool topped up
+    kproc_pool_fill();
+    timer_callback_register(&kproc_pool_fill, PROC_POOL_REFILL_INTERVAL, -1);
 
     // Create/execute the idle process (kproc_idle)
     pid = kproc_create(kproc_idle, "idle", PROC_TYPE_KERNEL);
@@ -285,5 +669,63 @@ void kproc_init(void) {
 
         kproc_attach_tty(pid, (TTY_MAX - (pid % 2) - 1));
     }
+
+#ifdef PROG_BENCH
+    // Semaphore round trip benchmark; reports to TTY 7
+    pid = kproc_create(prog_bench_ping, "bench_ping", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    pid = kproc_create(prog_bench_pong, "bench_pong", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    // Process spawn rate benchmark; reports to TTY 7
+    pid = kproc_create(prog_bench_spawn, "bench_spawn", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    // Shared memory and ring buffer throughput benchmarks; report to TTY 7
+    // The ring buffer pair is connected through PROC_IO_AUX
+    pid = kproc_create(prog_bench_shm_producer, "bench_shm_tx", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    pid = kproc_create(prog_bench_shm_consumer, "bench_shm_rx", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    ringbuf_t *bench_ringbuf = ringbuf_alloc();
+    proc_t *bench_proc;
+
+    if (!bench_ringbuf) {
+        kernel_log_warn("Unable to allocate the ring buffer benchmark's buffer");
+    } else {
+        pid = kproc_create(prog_bench_ringbuf_producer, "bench_ring_tx", PROC_TYPE_USER);
+        kproc_attach_tty(pid, 7);
+
+        bench_proc = pid < 0 ? NULL : pid_to_proc(pid);
+        if (bench_proc) {
+            bench_proc->io[PROC_IO_AUX] = bench_ringbuf;
+        }
+
+        pid = kproc_create(prog_bench_ringbuf_consumer, "bench_ring_rx", PROC_TYPE_USER);
+        kproc_attach_tty(pid, 7);
+
+        bench_proc = pid < 0 ? NULL : pid_to_proc(pid);
+        if (bench_proc) {
+            bench_proc->io[PROC_IO_AUX] = bench_ringbuf;
+        }
+    }
+
+    // User space and system call lock benchmark; reports to TTY 7
+    pid = kproc_create(prog_bench_lock, "bench_lock", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    // Pipe throughput benchmark; reports to TTY 7
+    pid = kproc_create(prog_bench_pipe, "bench_pipe", PROC_TYPE_USER);
+    kproc_attach_tty(pid, 7);
+
+    // Lazy FPU switching check; two FPU users preempting each other
+    for (int i = 0; i < 2; i++) {
+        pid = kproc_create(prog_bench_fpu, "bench_fpu", PROC_TYPE_USER);
+        kproc_attach_tty(pid, 7);
+    }
+#endif
 }
 
@@ -8,16 +8,17 @@
 
 #include <spede/string.h>
 
+#include "idtable.h"
 #include "kernel.h"
 #include "ksem.h"
-#include "queue.h"
+#include "kslab.h"
 #include "scheduler.h"
 
-// Table of all semephores
-sem_t semaphores[SEM_MAX];
+// Semaphore cache -> semaphores are allocated when they are created
+kmem_cache_t sem_cache = KMEM_CACHE("semaphore", sizeof(sem_t), 0, KMEM_CACHE_ZERO);
 
-// semaphore ids to be allocated
-queue_t sem_queue;
+// Table of all semaphores, indexed by semaphore id; grows on demand up to SEM_MAX
+idtable_t sem_table;
 
 /**
  * Initializes kernel semaphore data structures
@@ -26,23 +27,9 @@ queue_t sem_queue;
 int ksemaphores_init() {
     kernel_log_info("Initializing kernel semaphores");
 
-    // Initialize the semaphore table
-    for(int i=0; i < SEM_MAX; i++){
-        semaphores[i].allocated=0;
-        semaphores[i].count =0;
-        //initializes the queues?
-        kernel_log_info("Initializing the wait_queues in sem_t");
-        queue_init(&semaphores[i].wait_queue);
-    }
-    // Initialize the semaphore queue
-    queue_init(&sem_queue);
-    // Fill the semaphore queue
-    for(int i=0; i < SEM_MAX; i++){
-        if(queue_in(&sem_queue, i) !=0){
-            kernel_log_info("WARNING!!! At initialization unable to fill semaphore queue");
-            return -1;
-        }
-    }
+    // Semaphores are allocated from the semaphore cache when they are
+    // created, and the table is allocated with the first semaphore id
+    idtable_init(&sem_table, SEM_TABLE_INIT, SEM_MAX);
     return 0;
 }
 
@@ -52,27 +39,55 @@ int ksemaphores_init() {
  * @return -1 on error, otherwise the semaphore id that was allocated
  */
 int ksem_init(int value) {
-    // Obtain a semaphore id from the semaphore queue
     int id;
-    queue_out(&sem_queue, &id);
 
-    // Ensure that the id is within the valid range
-    if (id > SEM_MAX){
-        kernel_log_error("ksem_init: semaphore id %d invalid range", id);
+    if (value < 0) {
+        kernel_log_error("ksem_init: invalid initial value %d", value);
+        return -1;
+    }
+
+    // Allocate the semaphore; it is handed out clear
+    sem_t *sem_entry_ptr = kmem_cache_alloc(&sem_cache);
+
+    if (!sem_entry_ptr){
+        kernel_log_error("ksem_init: unable to allocate a semaphore");
         return -1;
     }
     // Initialize the semaphore data structure
     // sempohare table + all members (wait queue, allocated, count)
+    list_init(&sem_entry_ptr->wait_queue);
+    sem_entry_ptr->allocated = 1;
+    sem_entry_ptr->count = value;
+    // Bind the semaphore to a semaphore id
+    id = idtable_alloc(&sem_table, sem_entry_ptr);
+    if (id < 0){
+        kernel_log_error("ksem_init: no semaphore ids available");
+        memset(sem_entry_ptr, 0, sizeof(sem_t));
+        kmem_cache_free(&sem_cache, sem_entry_ptr);
+        return -1;
+    }
+    return id;
+}
+
+/**
+ * Looks up an allocated semaphore
+ * @param id - the semaphore id
+ * @return pointer to the semaphore, NULL if the id is invalid or not allocated
+ */
+static sem_t *ksem_get(int id) {
+    sem_t *sem;
 
-    sem_t *sem_entry_ptr = &semaphores[id];
+    if (id < 0 || id >= SEM_MAX){
+        kernel_log_error("semaphore id %d invalid range", id);
+        return NULL;
+    }
 
-    if (sem_entry_ptr){
-        sem_entry_ptr->allocated = 1;
-        //count should be set to 0 in  initialization
-        //wait_queue should already be initialized
-        return id;
+    sem = idtable_get(&sem_table, id);
+    if (!sem){
+        kernel_log_error("semaphore id %d is not allocated", id);
     }
-    return -1;
+
+    return sem;
 }
 
 /**
@@ -82,7 +97,7 @@ int ksem_init(int value) {
  */
 int ksem_destroy(int id) {
     // look up the sempaphore in the semaphore table
-    sem_t *sem_ptr = &semaphores[id];
+    sem_t *sem_ptr = ksem_get(id);
 
     if(sem_ptr){
         // If the semaphore is locked, prevent it from being destroyed
@@ -91,13 +106,14 @@ int ksem_destroy(int id) {
             return -1;
         }
 
-        // Add the id back into the semaphore queue to be re-used later
-        if(queue_in(&sem_queue, id) != 0){
-            kernel_log_error("error adding id back into mutex queue");
+        // Free the id to be re-used later
+        if(idtable_free(&sem_table, id) != 0){
+            kernel_log_error("error freeing the semaphore id");
             return -1;
         }
-        // Clear the memory for the data structure
+        // Clear the memory for the data structure and return it to the cache
         memset(sem_ptr, 0, sizeof(sem_t));
+        kmem_cache_free(&sem_cache, sem_ptr);
         kernel_log_info("semaphore cleared/destroyed");
         return 0;
     }
@@ -112,9 +128,13 @@ int ksem_destroy(int id) {
  */
 int ksem_wait(int id) {
     // look up the sempaphore in the semaphore table
-    sem_t *sem_ptr = &semaphores[id];
+    sem_t *sem_ptr = ksem_get(id);
     proc_t *proc = active_proc;
 
+    if (!sem_ptr){
+        return -1;
+    }
+
     if (!proc){
         kernel_panic("invalid process - called from ksem_wait()");
         return -1;
@@ -125,9 +145,7 @@ int ksem_wait(int id) {
         // add to the semaphore's wait queue
         // remove from the scheduler
     if (sem_ptr->count == 0){
-        proc->state = WAITING;
-        proc->scheduler_queue = &sem_ptr->wait_queue;
-        queue_in(&sem_ptr->wait_queue, proc->pid);
+        scheduler_wait(proc, &sem_ptr->wait_queue);
     }
 
     // If the semaphore count is > 0
@@ -149,18 +167,25 @@ int ksem_wait(int id) {
 int ksem_post(int id) {
 
     // look up the semaphore in the semaphore table
-    sem_t *sem_ptr = &semaphores[id];
+    sem_t *sem_ptr = ksem_get(id);
     proc_t *proc;
+
+    if (!sem_ptr){
+        return -1;
+    }
     // incrememnt the semaphore count
     sem_ptr->count ++;
 
     // check if any processes are waiting on the semaphore (semaphore wait queue)
         // if so, queue out and add to the scheduler
         // decrement the semaphore count
-    if (queue_out(&sem_ptr->wait_queue, &id)==0){
-        proc = pid_to_proc(id);
-        scheduler_add(proc);
+    proc = scheduler_wake(&sem_ptr->wait_queue);
+    if (proc){
         sem_ptr->count --;
+#if SCHEDULER_HANDOFF
+        // Switch directly to the waiting process
+        scheduler_handoff(proc);
+#endif
     }
     // return current semaphore count
 
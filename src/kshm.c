@@ -0,0 +1,231 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Shared Memory
+ *
+ * A region is a block of pages mapped into every process attached to it,
+ * so processes exchange data without copying it through the kernel.
+ * Processes synchronize access to a region with semaphores.
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kmem.h"
+#include "kshm.h"
+#include "kslab.h"
+#include "kvm.h"
+
+// Attachments are tracked in a bit mask per process
+#if SHM_MAX > 32
+#error "SHM_MAX exceeds the number of regions a process can track"
+#endif
+
+#if SHM_BASE + SHM_MAX * SHM_SIZE_MAX > KVM_STACK_TOP - KVM_STACK_MAX
+#error "Shared memory windows overlap the process stack range"
+#endif
+
+// Shared memory cache -> regions are allocated when they are created
+kmem_cache_t shm_cache = KMEM_CACHE("shm", sizeof(shm_t), 0, KMEM_CACHE_ZERO);
+
+// Table of all regions; NULL if the shared memory id is not allocated
+shm_t *shm_regions[SHM_MAX];
+
+/**
+ * Looks up an allocated region
+ * @param id - the shared memory id
+ * @return pointer to the region, NULL if the id is invalid or not allocated
+ */
+static shm_t *kshm_get(int id) {
+    if (id < 0 || id >= SHM_MAX) {
+        kernel_log_error("shm: id %d invalid range", id);
+        return NULL;
+    }
+
+    if (!shm_regions[id]) {
+        kernel_log_error("shm: id %d is not allocated", id);
+    }
+
+    return shm_regions[id];
+}
+
+/**
+ * Returns the address a region is mapped at in a process
+ * Without paging, processes share one address space and use the region's
+ * pages directly
+ * @param proc - process
+ * @param id - the shared memory id
+ * @return address of the region
+ */
+static unsigned char *kshm_addr(proc_t *proc, int id) {
+    if (!proc->page_dir) {
+        return shm_regions[id]->mem;
+    }
+
+    return (unsigned char *)(SHM_BASE + id * SHM_SIZE_MAX);
+}
+
+/**
+ * Creates a shared memory region and attaches the process to it
+ * The region starts out clear
+ * @param proc - process creating the region
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id that was allocated
+ */
+int kshm_create(proc_t *proc, int size) {
+    shm_t *shm;
+    int id;
+
+    if (!proc || size <= 0 || size > SHM_SIZE_MAX) {
+        return -1;
+    }
+
+    for (id = 0; id < SHM_MAX; id++) {
+        if (!shm_regions[id]) {
+            break;
+        }
+    }
+
+    if (id == SHM_MAX) {
+        kernel_log_error("shm: no shared memory ids available");
+        return -1;
+    }
+
+    shm = kmem_cache_alloc(&shm_cache);
+    if (!shm) {
+        kernel_log_error("shm: unable to allocate a region");
+        return -1;
+    }
+
+    shm->size = size;
+    while ((KMEM_PAGE_SIZE << shm->order) < size) {
+        shm->order++;
+    }
+
+    shm->mem = kmem_page_alloc(shm->order);
+    if (!shm->mem) {
+        kernel_log_error("shm: unable to allocate %d bytes", size);
+        kmem_cache_free(&shm_cache, shm);
+        return -1;
+    }
+
+    memset(shm->mem, 0, KMEM_PAGE_SIZE << shm->order);
+    shm_regions[id] = shm;
+
+    if (!kshm_attach(proc, id)) {
+        shm_regions[id] = NULL;
+        kmem_page_free(shm->mem);
+        memset(shm, 0, sizeof(shm_t));
+        kmem_cache_free(&shm_cache, shm);
+        return -1;
+    }
+
+    return id;
+}
+
+/**
+ * Attaches a process to a shared memory region
+ * @param proc - process to attach
+ * @param id - the shared memory identifier
+ * @return address of the region in the process, NULL on error
+ */
+void *kshm_attach(proc_t *proc, int id) {
+    shm_t *shm = kshm_get(id);
+    unsigned char *addr;
+
+    if (!shm || !proc) {
+        return NULL;
+    }
+
+    addr = kshm_addr(proc, id);
+
+    if (proc->shm_attached & (1u << id)) {
+        return addr;
+    }
+
+    // The pages are not owned by the address space, so they are left
+    // alone when it is destroyed
+    if (proc->page_dir) {
+        for (int offset = 0; offset < shm->size; offset += KMEM_PAGE_SIZE) {
+            if (kvm_map(proc->page_dir, (unsigned int)addr + offset, shm->mem + offset, KVM_WRITE) != 0) {
+                for (offset -= KMEM_PAGE_SIZE; offset >= 0; offset -= KMEM_PAGE_SIZE) {
+                    kvm_unmap(proc->page_dir, (unsigned int)addr + offset);
+                }
+
+                kernel_log_error("shm: unable to map region %d into process %d", id, proc->pid);
+                return NULL;
+            }
+        }
+    }
+
+    proc->shm_attached |= 1u << id;
+    shm->attached++;
+
+    return addr;
+}
+
+/**
+ * Detaches a process from a shared memory region
+ * The region is released when the last process detaches from it
+ * @param proc - process to detach
+ * @param id - the shared memory identifier
+ * @return 0 on success, -1 on error
+ */
+int kshm_detach(proc_t *proc, int id) {
+    shm_t *shm = kshm_get(id);
+    unsigned char *addr;
+
+    if (!shm || !proc || !(proc->shm_attached & (1u << id))) {
+        return -1;
+    }
+
+    if (proc->page_dir) {
+        addr = kshm_addr(proc, id);
+
+        for (int offset = 0; offset < shm->size; offset += KMEM_PAGE_SIZE) {
+            kvm_unmap(proc->page_dir, (unsigned int)addr + offset);
+        }
+    }
+
+    proc->shm_attached &= ~(1u << id);
+    shm->attached--;
+
+    if (shm->attached == 0) {
+        shm_regions[id] = NULL;
+        kmem_page_free(shm->mem);
+        memset(shm, 0, sizeof(shm_t));
+        kmem_cache_free(&shm_cache, shm);
+    }
+
+    return 0;
+}
+
+/**
+ * Attaches a forked process to its parent's shared memory regions
+ * The regions are already mapped in the copied address space
+ * @param parent - process that was forked
+ * @param child - copy of the process
+ */
+void kshm_fork(proc_t *parent, proc_t *child) {
+    child->shm_attached = parent->shm_attached;
+
+    for (int id = 0; id < SHM_MAX; id++) {
+        if (child->shm_attached & (1u << id)) {
+            shm_regions[id]->attached++;
+        }
+    }
+}
+
+/**
+ * Detaches a process from all of its shared memory regions
+ * @param proc - process to detach
+ */
+void kshm_release(proc_t *proc) {
+    for (int id = 0; id < SHM_MAX && proc->shm_attached; id++) {
+        if (proc->shm_attached & (1u << id)) {
+            kshm_detach(proc, id);
+        }
+    }
+}
@@ -0,0 +1,278 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Memory - Slab Caches
+ *
+ * Each slab is a block of pages from the page allocator carved into
+ * objects of one size. Free objects are linked through their first word.
+ * Slab state is kept in the descriptor of the slab's first page, so the
+ * whole block is available for objects.
+ */
+
+#include <spede/string.h>
+
+#include "kernel.h"
+#include "kmem.h"
+#include "kslab.h"
+#include "timer.h"
+
+// All caches that have been set up
+list_t kmem_caches;
+
+/**
+ * Sets up a cache on first use
+ * @param cache - pointer to the cache
+ */
+static void kmem_cache_setup(kmem_cache_t *cache) {
+    // Objects must be able to hold the free list link
+    if (cache->size < (int)sizeof(void *)) {
+        cache->size = sizeof(void *);
+    }
+
+    cache->size = (cache->size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+    cache->capacity = (KMEM_PAGE_SIZE << cache->order) / cache->size;
+
+    if (cache->capacity <= 0) {
+        kernel_panic("kmem: cache %s objects do not fit a slab", cache->name);
+    }
+
+    list_init(&cache->slabs_partial);
+    list_init(&cache->slabs_full);
+    list_init(&cache->slabs_empty);
+
+    list_append(&kmem_caches, &cache->node);
+    cache->registered = 1;
+}
+
+/**
+ * Creates a new slab for a cache
+ * @param cache - pointer to the cache
+ * @return pointer to the slab's page descriptor, NULL if no memory is available
+ */
+static kmem_page_t *kmem_slab_create(kmem_cache_t *cache) {
+    unsigned char *block;
+    kmem_page_t *slab;
+
+    block = kmem_page_alloc(cache->order);
+    if (!block) {
+        return NULL;
+    }
+
+    if (cache->flags & KMEM_CACHE_ZERO) {
+        memset(block, 0, KMEM_PAGE_SIZE << cache->order);
+    }
+
+    slab = kmem_addr_to_page(block);
+    slab->cache = cache;
+    slab->in_use = 0;
+    slab->objects = NULL;
+
+    // Link the objects so the lowest one is handed out first
+    for (int i = cache->capacity - 1; i >= 0; i--) {
+        void **obj = (void **)(block + i * cache->size);
+
+        *obj = slab->objects;
+        slab->objects = obj;
+    }
+
+    cache->slabs++;
+    cache->free += cache->capacity;
+
+    return slab;
+}
+
+/**
+ * Returns an empty slab to the page allocator
+ * @param cache - pointer to the cache
+ * @param slab - pointer to the slab's page descriptor
+ */
+static void kmem_slab_destroy(kmem_cache_t *cache, kmem_page_t *slab) {
+    list_remove(&cache->slabs_empty, &slab->node);
+
+    cache->slabs--;
+    cache->free -= cache->capacity;
+
+    slab->cache = NULL;
+    kmem_page_free(kmem_page_to_addr(slab));
+}
+
+/**
+ * Allocates an object from a cache
+ * @param cache - pointer to the cache
+ * @return pointer to the object, NULL if no memory is available
+ */
+void *kmem_cache_alloc(kmem_cache_t *cache) {
+    kmem_page_t *slab;
+    void **obj;
+
+    if (!cache) {
+        return NULL;
+    }
+
+    if (!cache->registered) {
+        kmem_cache_setup(cache);
+    }
+
+    // Use partially allocated slabs first so empty slabs can be released
+    if (!list_is_empty(&cache->slabs_partial)) {
+        slab = list_entry(cache->slabs_partial.head, kmem_page_t, node);
+    } else {
+        if (!list_is_empty(&cache->slabs_empty)) {
+            slab = list_entry(list_pop(&cache->slabs_empty), kmem_page_t, node);
+        } else {
+            slab = kmem_slab_create(cache);
+            if (!slab) {
+                kernel_log_warn("kmem: unable to grow cache %s", cache->name);
+                return NULL;
+            }
+        }
+
+        list_append(&cache->slabs_partial, &slab->node);
+    }
+
+    obj = slab->objects;
+    slab->objects = *obj;
+    slab->in_use++;
+
+    if (slab->in_use == cache->capacity) {
+        list_remove(&cache->slabs_partial, &slab->node);
+        list_append(&cache->slabs_full, &slab->node);
+    }
+
+    // The free list link is the only part of a clear object that was written
+    if (cache->flags & KMEM_CACHE_ZERO) {
+        *obj = NULL;
+    }
+
+    cache->in_use++;
+    cache->free--;
+    cache->allocs++;
+
+    return obj;
+}
+
+/**
+ * Returns an object to its cache
+ * @param cache - pointer to the cache
+ * @param obj - pointer to the object
+ */
+void kmem_cache_free(kmem_cache_t *cache, void *obj) {
+    kmem_page_t *page;
+    kmem_page_t *slab;
+
+    if (!cache || !obj) {
+        return;
+    }
+
+    // The slab's state is in the descriptor of its first page
+    page = kmem_addr_to_page(obj);
+    if (!page) {
+        kernel_panic("kmem: object 0x%08x is not in cache %s", (unsigned int)obj, cache->name);
+        return;
+    }
+
+    // Blocks are aligned to their size in pages, so the slab starts at the
+    // page index rounded down to the cache's order
+    slab = page - (kmem_page_index(page) & ((1 << cache->order) - 1));
+
+    if (slab->cache != cache) {
+        kernel_panic("kmem: object 0x%08x is not in cache %s", (unsigned int)obj, cache->name);
+        return;
+    }
+
+    if (slab->in_use == cache->capacity) {
+        list_remove(&cache->slabs_full, &slab->node);
+        list_append(&cache->slabs_partial, &slab->node);
+    }
+
+    *(void **)obj = slab->objects;
+    slab->objects = obj;
+    slab->in_use--;
+
+    cache->in_use--;
+    cache->free++;
+
+    if (slab->in_use == 0) {
+        list_remove(&cache->slabs_partial, &slab->node);
+
+        // Keep a single empty slab to absorb allocation bursts
+        list_append(&cache->slabs_empty, &slab->node);
+        if (cache->slabs_empty.size > 1) {
+            kmem_slab_destroy(cache, slab);
+        }
+    }
+}
+
+/**
+ * Releases the empty slabs of a cache
+ * @param cache - pointer to the cache
+ * @return number of pages released
+ */
+int kmem_cache_shrink(kmem_cache_t *cache) {
+    int pages = 0;
+
+    if (!cache || !cache->registered) {
+        return 0;
+    }
+
+    while (!list_is_empty(&cache->slabs_empty)) {
+        kmem_slab_destroy(cache, list_entry(cache->slabs_empty.head, kmem_page_t, node));
+        pages += 1 << cache->order;
+    }
+
+    return pages;
+}
+
+/**
+ * Cache timer callback
+ * Samples the allocation rate of each cache and shrinks caches that
+ * have been idle for the whole interval
+ */
+static void kmem_cache_timer(void) {
+    list_node_t *node;
+    kmem_cache_t *cache;
+
+    for (node = kmem_caches.head; node; node = node->next) {
+        cache = list_entry(node, kmem_cache_t, node);
+
+        cache->alloc_rate = cache->allocs - cache->allocs_sampled;
+        cache->allocs_sampled = cache->allocs;
+
+        if (cache->alloc_rate == 0) {
+            kmem_cache_shrink(cache);
+        }
+    }
+}
+
+/**
+ * Prints the statistics of every cache to the kernel log
+ */
+void kmem_cache_dump(void) {
+    list_node_t *node;
+    kmem_cache_t *cache;
+
+    kernel_log_info("kmem: %d of %d pages free", kmem_pages_free(), KMEM_PAGES);
+    kernel_log_info("kmem: cache         size  slabs  in use   free  allocs/s");
+
+    for (node = kmem_caches.head; node; node = node->next) {
+        cache = list_entry(node, kmem_cache_t, node);
+
+        kernel_log_info("kmem: %-12s %5d  %5d  %6d  %5d  %8d",
+                        cache->name, cache->size, cache->slabs, cache->in_use, cache->free,
+                        cache->alloc_rate * 100 / KMEM_CACHE_REAP_INTERVAL);
+    }
+}
+
+/**
+ * Initializes the slab caches
+ * Registers the timer that samples statistics and shrinks idle caches
+ */
+void kmem_caches_init(void) {
+    kernel_log_info("kmem: Initializing slab caches");
+
+    list_init(&kmem_caches);
+
+    timer_callback_register(&kmem_cache_timer, KMEM_CACHE_REAP_INTERVAL, -1);
+}
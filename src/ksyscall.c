@@ -17,6 +17,9 @@
 #include "timer.h"
 #include "ksem.h"
 #include "kmutex.h"
+#include "kfutex.h"
+#include "kpipe.h"
+#include "kshm.h"
 
 /**
  * System call IRQ handler
@@ -34,10 +37,16 @@ void ksyscall_irq_handler(void) {
     unsigned int arg2;
     unsigned int arg3;
 
+    // Process making the system call
+    proc_t *proc = active_proc;
+    int pid;
+
     if (!active_proc) {
         kernel_panic("Invalid process");
     }
 
+    pid = proc->pid;
+
     if (!active_proc->trapframe) {
         kernel_panic("Invalid trapframe");
     }
@@ -77,6 +86,10 @@ void ksyscall_irq_handler(void) {
             rc = ksyscall_proc_sleep((int)arg1);
             break;
 
+        case SYSCALL_PROC_YIELD:
+            rc = ksyscall_proc_yield();
+            break;
+
         case SYSCALL_PROC_EXIT:
             rc = ksyscall_proc_exit();
             break;
@@ -89,6 +102,26 @@ void ksyscall_irq_handler(void) {
             rc = ksyscall_proc_get_name((char *)arg1);
             break;
 
+        case SYSCALL_PROC_SET_PRIORITY:
+            rc = ksyscall_proc_set_priority((int)arg1);
+            break;
+
+        case SYSCALL_PROC_GET_PRIORITY:
+            rc = ksyscall_proc_get_priority();
+            break;
+
+        case SYSCALL_PROC_SET_PERIODIC:
+            rc = ksyscall_proc_set_periodic((int)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_PROC_SPAWN:
+            rc = ksyscall_proc_spawn((void *)arg1, (char *)arg2, (int)arg3);
+            break;
+
+        case SYSCALL_PROC_FORK:
+            rc = ksyscall_proc_fork();
+            break;
+
         case SYSCALL_MUTEX_INIT:
             rc = ksyscall_mutex_init();
             break;
@@ -121,13 +154,59 @@ void ksyscall_irq_handler(void) {
             rc = ksyscall_sem_wait(arg1);
             break;
 
+        case SYSCALL_SHM_CREATE:
+            rc = ksyscall_shm_create((int)arg1);
+            break;
+
+        case SYSCALL_SHM_ATTACH:
+            rc = ksyscall_shm_attach((int)arg1);
+            break;
+
+        case SYSCALL_SHM_DETACH:
+            rc = ksyscall_shm_detach((int)arg1);
+            break;
+
+        case SYSCALL_FUTEX_WAIT:
+            rc = ksyscall_futex_wait((int *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_FUTEX_WAKE:
+            rc = ksyscall_futex_wake((int *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_FUTEX_LOCK:
+            rc = ksyscall_futex_lock((int *)arg1);
+            break;
+
+        case SYSCALL_FUTEX_UNLOCK:
+            rc = ksyscall_futex_unlock((int *)arg1);
+            break;
+
+        case SYSCALL_PIPE:
+            rc = ksyscall_pipe((int *)arg1, (int)arg2);
+            break;
+
+        case SYSCALL_IO_CLOSE:
+            rc = ksyscall_io_close((int)arg1);
+            break;
+
         default:
             kernel_panic("Invalid system call %d!", syscall);
     }
 
     // Ensure that the EAX register contains a return value (if appropriate)
-    if (active_proc) {
-        active_proc->trapframe->eax = (unsigned int)rc;
+    // The caller may have been unscheduled (i.e. blocked on a wait queue),
+    // so the return value is stored unless the process no longer exists
+    // An exited process' control block has been freed, so look it up again
+    proc = pid_to_proc(pid);
+    if (proc && proc->trapframe) {
+        if (rc == KSYSCALL_RESTART) {
+            // Back up over the int instruction; the registers still hold
+            // the system call and its arguments
+            proc->trapframe->eip -= 2;
+        } else {
+            proc->trapframe->eax = (unsigned int)rc;
+        }
     }
 }
 
@@ -141,20 +220,24 @@ void ksyscall_init(void) {
 
 /**
  * Writes up to n bytes to the process' specified IO buffer
- * @param io - the IO buffer to write to
+ * Copies as many bytes as fit, blocking until there is space unless
+ * PROC_IO_NONBLOCK is set in io
+ * @param io - the IO buffer to write to, optionally with PROC_IO_NONBLOCK
  * @param buf - the buffer to copy from
  * @param n - number of bytes to write
- * @return -1 on error or value indicating number of bytes copied
+ * @return -1 on error, KSYSCALL_RESTART if the process blocked, or value
+ *         indicating number of bytes copied
  */
 int ksyscall_io_write(int io, char *buf, int size) {
-    if (!active_proc) {
-        return -1;
-    }
+    int nonblock = io & PROC_IO_NONBLOCK;
+    int rc;
 
     if (!active_proc) {
         return -1;
     }
 
+    io &= ~(PROC_IO_NONBLOCK | PROC_IO_SHORT);
+
     if (io < 0 || io >= PROC_IO_MAX) {
         return -1;
     }
@@ -163,21 +246,58 @@ int ksyscall_io_write(int io, char *buf, int size) {
         return -1;
     }
 
-    return ringbuf_write_mem(active_proc->io[io], buf, size);
+    if (size < 0) {
+        return -1;
+    }
+
+    // Pipes are written through the write end, while a read end is open
+    if (active_proc->io_pipe[io] == PROC_PIPE_READ) {
+        return -1;
+    }
+
+    if (active_proc->io_pipe[io] && active_proc->io[io]->read_ends == 0) {
+        return -1;
+    }
+
+    // Block until a reader makes space; the write is retried when the
+    // process is woken up
+    if (ringbuf_is_full(active_proc->io[io]) && !nonblock && size > 0) {
+        scheduler_wait(active_proc, &active_proc->io[io]->writers);
+        return KSYSCALL_RESTART;
+    }
+
+    rc = ringbuf_write_partial(active_proc->io[io], buf, size);
+
+    // Readers blocked on the buffer retry their reads
+    if (rc > 0) {
+        while (scheduler_wake(&active_proc->io[io]->readers));
+    }
+
+    return rc;
 }
 
 /**
  * Reads up to n bytes from the process' specified IO buffer
- * @param io - the IO buffer to read from
+ * Blocks until data is available unless PROC_IO_NONBLOCK is set in io;
+ * returns 0 at the end of a pipe
+ * @param io - the IO buffer to read from, optionally with PROC_IO_NONBLOCK
+ *             (PROC_IO_SHORT is accepted; reads never wait for all n bytes)
  * @param buf - the buffer to copy to
  * @param n - number of bytes to read
- * @return -1 on error or value indicating number of bytes copied
+ * @return -1 on error, KSYSCALL_RESTART if the process blocked, or value
+ *         indicating number of bytes copied
  */
 int ksyscall_io_read(int io, char *buf, int size) {
+    int nonblock = io & PROC_IO_NONBLOCK;
+    int rc;
+
     if (!active_proc) {
         return -1;
     }
 
+    // Reads always return what is available, so PROC_IO_SHORT changes nothing
+    io &= ~(PROC_IO_NONBLOCK | PROC_IO_SHORT);
+
     if (io < 0 || io >= PROC_IO_MAX) {
         return -1;
     }
@@ -186,8 +306,36 @@ int ksyscall_io_read(int io, char *buf, int size) {
         return -1;
     }
 
-    return ringbuf_read_mem(active_proc->io[io], buf, size);
+    if (size < 0) {
+        return -1;
+    }
+
+    // Pipes are read through the read end
+    if (active_proc->io_pipe[io] == PROC_PIPE_WRITE) {
+        return -1;
+    }
+
+    // An empty pipe without write ends is at its end
+    if (ringbuf_is_empty(active_proc->io[io]) && active_proc->io_pipe[io]
+        && active_proc->io[io]->write_ends == 0) {
+        return 0;
+    }
+
+    // Block until data is written; the read is retried when the process
+    // is woken up, in its own address space where the buffer is mapped
+    if (ringbuf_is_empty(active_proc->io[io]) && !nonblock && size > 0) {
+        scheduler_wait(active_proc, &active_proc->io[io]->readers);
+        return KSYSCALL_RESTART;
+    }
+
+    rc = ringbuf_read_mem(active_proc->io[io], buf, size);
+
+    // Writers blocked on the buffer retry their writes
+    if (rc > 0) {
+        while (scheduler_wake(&active_proc->io[io]->writers));
+    }
 
+    return rc;
 }
 
 /**
@@ -210,6 +358,9 @@ int ksyscall_io_flush(int io) {
 
     ringbuf_flush(active_proc->io[io]);
 
+    // Writers blocked on the buffer retry their writes
+    while (scheduler_wake(&active_proc->io[io]->writers));
+
     return 0;
 }
 
@@ -244,6 +395,19 @@ int ksyscall_proc_sleep(int seconds) {
     return 0;
 }
 
+/**
+ * Yields the CPU to other processes that are ready to run
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_yield(void) {
+    if (!active_proc) {
+        return -1;
+    }
+
+    scheduler_yield(active_proc);
+    return 0;
+}
+
 /**
  * Exits the current process
  */
@@ -277,6 +441,95 @@ int ksyscall_proc_get_name(char *name) {
     return 0;
 }
 
+/**
+ * Sets the active process' scheduling priority
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_set_priority(int priority) {
+    if (!active_proc) {
+        return -1;
+    }
+
+    return scheduler_set_priority(active_proc, priority);
+}
+
+/**
+ * Gets the active process' scheduling priority
+ * @return priority level or -1 on error
+ */
+int ksyscall_proc_get_priority(void) {
+    if (!active_proc) {
+        return -1;
+    }
+
+    return active_proc->base_priority;
+}
+
+/**
+ * Makes the active process periodic; each job must complete (by yielding)
+ * within its budget before the end of its period
+ * @param period - number of ticks between job releases, 0 to clear
+ * @param budget - number of ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int ksyscall_proc_set_periodic(int period, int budget) {
+    if (!active_proc) {
+        return -1;
+    }
+
+    return scheduler_set_periodic(active_proc, period, budget);
+}
+
+/**
+ * Creates a new process
+ * The process is built from a pre-initialized template, so this only
+ * assigns a process id and sets the entry point
+ * @param entry - function the process starts executing
+ * @param name - process name
+ * @param flags - PROC_SPAWN_TTY to attach the process to the active process' TTY,
+ *                PROC_SPAWN_PIPES to pass it the active process' pipe ends
+ * @return process id of the new process, -1 on error
+ */
+int ksyscall_proc_spawn(void *entry, char *name, int flags) {
+    proc_t *proc;
+    int pid;
+
+    if (!active_proc || !entry || !name) {
+        return -1;
+    }
+
+    pid = kproc_create(entry, name, PROC_TYPE_USER);
+    proc = pid_to_proc(pid);
+    if (!proc) {
+        return -1;
+    }
+
+    if (flags & PROC_SPAWN_TTY) {
+        kpipe_dup(active_proc, proc, PROC_IO_IN);
+        kpipe_dup(active_proc, proc, PROC_IO_OUT);
+    }
+
+    if (flags & PROC_SPAWN_PIPES) {
+        kpipe_fork(active_proc, proc);
+    }
+
+    return pid;
+}
+
+/**
+ * Creates a copy of the active process
+ * The copy shares the active process' pages until either one writes to them
+ * @return process id of the copy, -1 on error
+ */
+int ksyscall_proc_fork(void) {
+    if (!active_proc) {
+        return -1;
+    }
+
+    return kproc_fork(active_proc);
+}
+
 /**
  * Allocates a mutex from the kernel
  * @return -1 on error, all other values indicate the mutex id
@@ -310,7 +563,7 @@ int ksyscall_mutex_lock(int mutex) {
     }
     int lock_count = kmutex_lock(mutex);
     if (lock_count >= 0){
-        kernel_log_info("ksyscall_mutex_lock success");
+        kernel_log_trace("ksyscall_mutex_lock success");
         return 0;
     }
     kernel_log_error("ksyscall_mutex_lock error");
@@ -329,7 +582,7 @@ int ksyscall_mutex_unlock(int mutex) {
     }
     int lock_count = kmutex_unlock(mutex);
     if (lock_count >= 0){
-        kernel_log_info("ksyscall_mutex_unlock success");
+        kernel_log_trace("ksyscall_mutex_unlock success");
         return 0;
     }
     kernel_log_error("ksyscall_mutex_unlock error");
@@ -370,7 +623,7 @@ int ksyscall_sem_wait(int sem) {
     }
     int sem_count = ksem_wait(sem);
     if (sem_count >= 0){
-        kernel_log_info("ksyscall_sem_wait - ok");
+        kernel_log_trace("ksyscall_sem_wait - ok");
         return sem_count;
     }
     kernel_log_error("ksyscall_sem_wait error occurred");
@@ -389,10 +642,97 @@ int ksyscall_sem_post(int sem) {
     }
     int sem_count = ksem_post(sem);
     if (sem_count >= 0){
-        kernel_log_info("kyscall_sem_post - ok");
+        kernel_log_trace("kyscall_sem_post - ok");
         return sem_count;
     }
     kernel_log_error("ksyscall_sem_post error occurred");
     return -1;
 }
 
+/**
+ * Creates a shared memory region and attaches the active process to it
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id
+ */
+int ksyscall_shm_create(int size) {
+    return kshm_create(active_proc, size);
+}
+
+/**
+ * Attaches the active process to a shared memory region
+ * @param shm - shared memory id
+ * @return address of the region, 0 on error
+ */
+int ksyscall_shm_attach(int shm) {
+    return (int)kshm_attach(active_proc, shm);
+}
+
+/**
+ * Detaches the active process from a shared memory region
+ * @param shm - shared memory id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_shm_detach(int shm) {
+    return kshm_detach(active_proc, shm);
+}
+
+/**
+ * Blocks the active process until the futex is woken, if the futex word
+ * still holds the expected value
+ * @param addr - address of the futex word
+ * @param val - value the caller last saw in the futex word
+ * @return 0 once woken, -1 if the value changed or on error
+ */
+int ksyscall_futex_wait(int *addr, int val) {
+    return kfutex_wait(active_proc, addr, val);
+}
+
+/**
+ * Wakes processes waiting on a futex
+ * @param addr - address of the futex word
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int ksyscall_futex_wake(int *addr, int count) {
+    return kfutex_wake(active_proc, addr, count);
+}
+
+/**
+ * Locks a priority inheritance futex for the active process
+ * @param addr - address of the futex word
+ * @return 0 once the active process owns the futex, -1 on error
+ */
+int ksyscall_futex_lock(int *addr) {
+    return kfutex_lock(active_proc, addr);
+}
+
+/**
+ * Unlocks a priority inheritance futex owned by the active process
+ * @param addr - address of the futex word
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_futex_unlock(int *addr) {
+    return kfutex_unlock(active_proc, addr);
+}
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of the active process
+ * Reads of an empty pipe return 0 once every write end is closed; writes
+ * fail once every read end is closed
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_pipe(int *ends, int size) {
+    return kpipe_create(active_proc, ends, size);
+}
+
+/**
+ * Closes an IO slot of the active process
+ * A pipe is released when the last IO slot referring to it is closed
+ * @param io - the IO id
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_io_close(int io) {
+    return kpipe_close(active_proc, io);
+}
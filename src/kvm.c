@@ -0,0 +1,609 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Virtual Memory - Paging
+ *
+ * Physical memory from 0 up to the end of the kernel heap is identity
+ * mapped with 4MB pages marked global, so the kernel runs at the same
+ * addresses in every address space and its TLB entries are kept when
+ * CR3 is reloaded. Each process has its own page directory that starts
+ * out with only the kernel mappings.
+ *
+ * Processes run in ring 0, so a fault on an unmapped stack page can not
+ * be handled on that stack. Page faults are delivered through a task
+ * gate instead: the CPU switches to a separate task with its own stack,
+ * which maps the page and returns to the faulting instruction.
+ *
+ * Forked address spaces share their pages read-only (copy-on-write) until
+ * one side writes to a page. CR0.WP is set so writes from ring 0 respect
+ * the read-only mappings.
+ */
+
+#include <spede/string.h>
+#include <spede/machine/proc_reg.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kmem.h"
+#include "kvm.h"
+
+// CPUID feature flags (EDX of leaf 1)
+#define CPUID_PSE   (1 << 3)    // Page size extension (4MB pages)
+#define CPUID_PGE   (1 << 13)   // Global pages
+
+// Control register flags
+#define CR0_WP      0x00010000  // Read-only pages are enforced in ring 0
+#define CR0_PG      0x80000000  // Paging enabled
+#define CR4_PSE     0x00000010  // Page size extension enabled
+#define CR4_PGE     0x00000080  // Global pages enabled
+
+// Page fault error code flags
+#define KVM_FAULT_PRESENT   0x01    // Fault on a present page (protection violation)
+#define KVM_FAULT_WRITE     0x02    // Fault on a write
+
+// Maximum number of GDT entries, including the ones added for the tasks
+#define KVM_GDT_MAX 32
+
+// Task state segment
+typedef struct kvm_tss_t {
+    unsigned int link;
+    unsigned int esp0, ss0;
+    unsigned int esp1, ss1;
+    unsigned int esp2, ss2;
+    unsigned int cr3;
+    unsigned int eip;
+    unsigned int eflags;
+    unsigned int eax, ecx, edx, ebx;
+    unsigned int esp, ebp, esi, edi;
+    unsigned int es, cs, ss, ds, fs, gs;
+    unsigned int ldt;
+    unsigned short trap;
+    unsigned short iomap;
+} kvm_tss_t;
+
+// Segment descriptor
+typedef struct kvm_desc_t {
+    unsigned int lo;
+    unsigned int hi;
+} kvm_desc_t;
+
+// Pseudo-descriptor used by lgdt/sgdt
+typedef struct kvm_gdtr_t {
+    unsigned short limit;
+    unsigned int base;
+} __attribute__((packed)) kvm_gdtr_t;
+
+// Page directory with the kernel mappings
+unsigned int *kvm_kernel_dir;
+
+// Page directory that is loaded in CR3
+unsigned int *kvm_dir_current;
+
+// Number of page directory entries used by the kernel mappings
+int kvm_kernel_entries;
+
+// Global descriptor table; the loader's entries followed by the TSSs
+kvm_desc_t kvm_gdt[KVM_GDT_MAX];
+
+// State of the interrupted task while a page fault is handled
+kvm_tss_t kvm_tss_main;
+
+// Page fault task entry; defined in context.S
+extern void kvm_fault_entry();
+
+// Page fault handling task and its stack
+kvm_tss_t kvm_tss_fault;
+unsigned char kvm_fault_stack[KVM_FAULT_STACK_SIZE];
+
+// Number of stack pages mapped on first touch, and currently allocated
+int kvm_stack_faults;
+int kvm_stack_pages;
+
+// Number of copy-on-write pages copied
+int kvm_cow_copies;
+
+/**
+ * Returns the CPU feature flags
+ * @return EDX of CPUID leaf 1
+ */
+static unsigned int kvm_cpu_features(void) {
+    unsigned int eax = 1;
+    unsigned int ebx;
+    unsigned int ecx;
+    unsigned int edx;
+
+    asm volatile("cpuid" : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+
+    return edx;
+}
+
+/**
+ * Loads a page directory into CR3
+ * @param dir - pointer to the page directory
+ */
+static void kvm_dir_load(unsigned int *dir) {
+    kvm_dir_current = dir;
+    asm volatile("movl %0, %%cr3" : : "r"(dir) : "memory");
+}
+
+/**
+ * Indicates if paging is enabled
+ * @return non-zero if paging is enabled
+ */
+int kvm_enabled(void) {
+    return kvm_kernel_dir != NULL;
+}
+
+/**
+ * Creates an address space
+ * The kernel mappings are shared by all address spaces
+ * @return pointer to the page directory, NULL if paging is disabled or no memory is available
+ */
+unsigned int *kvm_dir_create(void) {
+    unsigned int *dir;
+
+    if (!kvm_kernel_dir) {
+        return NULL;
+    }
+
+    dir = kmem_page_alloc(0);
+    if (!dir) {
+        kernel_log_warn("kvm: unable to allocate a page directory");
+        return NULL;
+    }
+
+    memcpy(dir, kvm_kernel_dir, kvm_kernel_entries * sizeof(unsigned int));
+    memset(&dir[kvm_kernel_entries], 0, (KVM_ENTRIES - kvm_kernel_entries) * sizeof(unsigned int));
+
+    return dir;
+}
+
+/**
+ * Destroys an address space, releasing its page tables and the pages it owns
+ * @param dir - pointer to the page directory
+ */
+void kvm_dir_destroy(unsigned int *dir) {
+    unsigned int *table;
+    kmem_page_t *page;
+
+    if (!dir || dir == kvm_kernel_dir) {
+        return;
+    }
+
+    // Move to the kernel address space if this one is in use, since the
+    // directory may be reused as soon as it is freed
+    if (kvm_dir_current == dir) {
+        kvm_dir_load(kvm_kernel_dir);
+    }
+
+    // Page tables of the process' own mappings
+    for (int i = kvm_kernel_entries; i < KVM_ENTRIES; i++) {
+        if (!(dir[i] & KVM_PRESENT) || (dir[i] & KVM_LARGE)) {
+            continue;
+        }
+
+        table = (unsigned int *)(dir[i] & KVM_ADDR_MASK);
+
+        for (int j = 0; j < KVM_ENTRIES; j++) {
+            unsigned int vaddr = ((unsigned int)i << KVM_LARGE_SHIFT) | (j << KMEM_PAGE_SHIFT);
+
+            if ((table[j] & (KVM_PRESENT | KVM_OWNED)) != (KVM_PRESENT | KVM_OWNED)) {
+                continue;
+            }
+
+            // A page still shared with another address space stays with it
+            page = kmem_addr_to_page((void *)(table[j] & KVM_ADDR_MASK));
+            if (page->shares > 0) {
+                page->shares--;
+                continue;
+            }
+
+            kmem_page_free((void *)(table[j] & KVM_ADDR_MASK));
+
+            if (vaddr >= KVM_STACK_TOP - KVM_STACK_MAX && vaddr < KVM_STACK_TOP) {
+                kvm_stack_pages--;
+            }
+        }
+
+        kmem_page_free(table);
+    }
+
+    kmem_page_free(dir);
+}
+
+/**
+ * Creates a copy of an address space
+ * Pages the address space owns are shared with the copy and made read-only
+ * in both; each side gets its own copy of a page the first time it writes
+ * to it. The cost is proportional to the number of page table entries.
+ * The kernel mappings (including the data of user programs, which are
+ * linked into the kernel image) stay shared and writable in both.
+ * @param dir - pointer to the page directory to copy
+ * @return pointer to the new page directory, NULL if no memory is available
+ */
+unsigned int *kvm_dir_clone(unsigned int *dir) {
+    unsigned int *clone;
+    unsigned int *table;
+    unsigned int *clone_table;
+    unsigned int pte;
+
+    clone = kvm_dir_create();
+    if (!clone) {
+        return NULL;
+    }
+
+    for (int i = kvm_kernel_entries; i < KVM_ENTRIES; i++) {
+        if (!(dir[i] & KVM_PRESENT) || (dir[i] & KVM_LARGE)) {
+            continue;
+        }
+
+        clone_table = kmem_page_alloc(0);
+        if (!clone_table) {
+            kernel_log_warn("kvm: unable to allocate a page table");
+            kvm_dir_destroy(clone);
+            return NULL;
+        }
+
+        table = (unsigned int *)(dir[i] & KVM_ADDR_MASK);
+
+        for (int j = 0; j < KVM_ENTRIES; j++) {
+            pte = table[j];
+
+            // Owned pages are shared; writable ones become copy-on-write
+            if ((pte & (KVM_PRESENT | KVM_OWNED)) == (KVM_PRESENT | KVM_OWNED)) {
+                if (pte & (KVM_WRITE | KVM_COW)) {
+                    pte = (pte & ~KVM_WRITE) | KVM_COW;
+                    table[j] = pte;
+                }
+
+                kmem_addr_to_page((void *)(pte & KVM_ADDR_MASK))->shares++;
+            }
+
+            clone_table[j] = pte;
+        }
+
+        clone[i] = (unsigned int)clone_table | (dir[i] & ~KVM_ADDR_MASK);
+    }
+
+    // Drop the writable translations the source may have cached
+    if (dir == kvm_dir_current) {
+        kvm_dir_load(dir);
+    }
+
+    return clone;
+}
+
+/**
+ * Gives an address space its own writable copy of a copy-on-write page
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address within the page
+ * @return physical address of the page, NULL if the page is not copy-on-write or no memory is available
+ */
+unsigned char *kvm_cow_break(unsigned int *dir, unsigned int vaddr) {
+    unsigned int *pte = kvm_lookup(dir, vaddr);
+    unsigned char *old;
+    unsigned char *new;
+    kmem_page_t *page;
+
+    if (!pte || (*pte & (KVM_PRESENT | KVM_COW)) != (KVM_PRESENT | KVM_COW)) {
+        return NULL;
+    }
+
+    old = (unsigned char *)(*pte & KVM_ADDR_MASK);
+    page = kmem_addr_to_page(old);
+
+    // The last address space mapping the page can simply take it over
+    if (page->shares == 0) {
+        new = old;
+    } else {
+        new = kmem_page_alloc(0);
+        if (!new) {
+            return NULL;
+        }
+
+        memcpy(new, old, KMEM_PAGE_SIZE);
+        page->shares--;
+
+        kvm_cow_copies++;
+        if (vaddr >= KVM_STACK_TOP - KVM_STACK_MAX && vaddr < KVM_STACK_TOP) {
+            kvm_stack_pages++;
+        }
+    }
+
+    *pte = (unsigned int)new | (*pte & ~(KVM_ADDR_MASK | KVM_COW)) | KVM_WRITE;
+
+    if (dir == kvm_dir_current) {
+        asm volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    }
+
+    return new;
+}
+
+/**
+ * Returns the number of copy-on-write pages that have been copied
+ * @return number of pages copied
+ */
+int kvm_pages_copied(void) {
+    return kvm_cow_copies;
+}
+
+/**
+ * Looks up the page table entry of a virtual address
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address
+ * @return pointer to the page table entry, NULL if there is no page table
+ */
+unsigned int *kvm_lookup(unsigned int *dir, unsigned int vaddr) {
+    unsigned int pde = dir[vaddr >> KVM_LARGE_SHIFT];
+
+    if (!(pde & KVM_PRESENT) || (pde & KVM_LARGE)) {
+        return NULL;
+    }
+
+    return &((unsigned int *)(pde & KVM_ADDR_MASK))[(vaddr >> KMEM_PAGE_SHIFT) & (KVM_ENTRIES - 1)];
+}
+
+/**
+ * Maps a page into an address space
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address of the page
+ * @param page - physical address of the page
+ * @param flags - page table entry flags
+ * @return 0 on success, -1 if no memory is available for the page table
+ */
+int kvm_map(unsigned int *dir, unsigned int vaddr, void *page, int flags) {
+    unsigned int *pde = &dir[vaddr >> KVM_LARGE_SHIFT];
+    unsigned int *table;
+
+    if ((*pde & KVM_PRESENT) && (*pde & KVM_LARGE)) {
+        kernel_panic("kvm: 0x%08x is in a large page", vaddr);
+        return -1;
+    }
+
+    // Allocate the page table on first use
+    // Access is controlled by the page table entries
+    if (!(*pde & KVM_PRESENT)) {
+        table = kmem_page_alloc(0);
+        if (!table) {
+            return -1;
+        }
+
+        memset(table, 0, KMEM_PAGE_SIZE);
+        *pde = (unsigned int)table | KVM_PRESENT | KVM_WRITE | KVM_USER;
+    }
+
+    *kvm_lookup(dir, vaddr) = ((unsigned int)page & KVM_ADDR_MASK) | flags | KVM_PRESENT;
+
+    if (dir == kvm_dir_current) {
+        asm volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    }
+
+    return 0;
+}
+
+/**
+ * Removes the mapping of a page from an address space
+ * The page itself is not released
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address of the page
+ */
+void kvm_unmap(unsigned int *dir, unsigned int vaddr) {
+    unsigned int *pte = kvm_lookup(dir, vaddr);
+
+    if (!pte) {
+        return;
+    }
+
+    *pte = 0;
+
+    if (dir == kvm_dir_current) {
+        asm volatile("invlpg (%0)" : : "r"(vaddr) : "memory");
+    }
+}
+
+/**
+ * Maps a zeroed page into the stack range of an address space
+ * @param dir - pointer to the page directory
+ * @param vaddr - virtual address within the page
+ * @return physical address of the page, NULL if no memory is available
+ */
+static unsigned char *kvm_stack_map(unsigned int *dir, unsigned int vaddr) {
+    unsigned char *page = kmem_page_alloc(0);
+
+    if (!page) {
+        return NULL;
+    }
+
+    memset(page, 0, KMEM_PAGE_SIZE);
+
+    if (kvm_map(dir, vaddr & KVM_ADDR_MASK, page, KVM_WRITE | KVM_OWNED) != 0) {
+        kmem_page_free(page);
+        return NULL;
+    }
+
+    kvm_stack_pages++;
+
+    return page;
+}
+
+/**
+ * Sets up the stack range of an address space
+ * Only the top page is mapped; the rest is mapped as it is first touched
+ * @param dir - pointer to the page directory
+ * @return physical address of the top stack page, NULL if no memory is available
+ */
+unsigned char *kvm_stack_create(unsigned int *dir) {
+    return kvm_stack_map(dir, KVM_STACK_TOP - KMEM_PAGE_SIZE);
+}
+
+/**
+ * Page fault handler; runs as its own task
+ * Backs untouched stack pages with zero pages and copies copy-on-write
+ * pages that are written to. Any other fault is fatal.
+ * @param error - page fault error code
+ */
+void kvm_fault_handler(unsigned int error) {
+    unsigned int addr;
+    unsigned int *pte;
+
+    asm volatile("movl %%cr2, %0" : "=r"(addr));
+
+    // The faulting task resumes in the address space it faulted in
+    kvm_tss_main.cr3 = (unsigned int)kvm_dir_current;
+
+    if ((error & (KVM_FAULT_PRESENT | KVM_FAULT_WRITE)) == (KVM_FAULT_PRESENT | KVM_FAULT_WRITE)) {
+        pte = kvm_lookup(kvm_dir_current, addr);
+
+        if (pte && (*pte & KVM_COW)) {
+            if (!kvm_cow_break(kvm_dir_current, addr)) {
+                kernel_panic("kvm: unable to copy a page for process %d", active_proc ? active_proc->pid : -1);
+            }
+
+            return;
+        }
+    }
+
+    if (!(error & KVM_FAULT_PRESENT)
+        && addr >= KVM_STACK_TOP - KVM_STACK_MAX + KMEM_PAGE_SIZE && addr < KVM_STACK_TOP) {
+        if (!kvm_stack_map(kvm_dir_current, addr)) {
+            kernel_panic("kvm: unable to grow the stack of process %d", active_proc ? active_proc->pid : -1);
+        }
+
+        kvm_stack_faults++;
+        return;
+    }
+
+    if (addr >= KVM_STACK_TOP - KVM_STACK_MAX && addr < KVM_STACK_TOP - KVM_STACK_MAX + KMEM_PAGE_SIZE) {
+        kernel_panic("kvm: stack overflow in process %d at eip=0x%08x",
+                     active_proc ? active_proc->pid : -1, kvm_tss_main.eip);
+    }
+
+    kernel_panic("kvm: page fault at 0x%08x, error=0x%x, eip=0x%08x", addr, error, kvm_tss_main.eip);
+}
+
+/**
+ * Sets a GDT entry to describe a TSS
+ * @param index - GDT index
+ * @param tss - pointer to the TSS
+ */
+static void kvm_gdt_set_tss(int index, kvm_tss_t *tss) {
+    unsigned int base = (unsigned int)tss;
+    unsigned int limit = sizeof(kvm_tss_t) - 1;
+
+    // Present, DPL 0, 32-bit available TSS
+    kvm_gdt[index].lo = (limit & 0xffff) | ((base & 0xffff) << 16);
+    kvm_gdt[index].hi = ((base >> 16) & 0xff) | 0x8900 | (limit & 0xf0000) | (base & 0xff000000);
+}
+
+/**
+ * Sets up the page fault task
+ * The loader's GDT is extended with a TSS for the running task, which
+ * holds its state while a fault is handled, and one for the fault task
+ */
+static void kvm_fault_init(void) {
+    kvm_gdtr_t gdtr;
+    int entries;
+
+    asm volatile("sgdt %0" : "=m"(gdtr));
+
+    entries = (gdtr.limit + 1) / sizeof(kvm_desc_t);
+    if (entries + 2 > KVM_GDT_MAX) {
+        kernel_panic("kvm: no room in the GDT for the page fault task");
+        return;
+    }
+
+    memcpy(kvm_gdt, (void *)gdtr.base, entries * sizeof(kvm_desc_t));
+
+    memset(&kvm_tss_main, 0, sizeof(kvm_tss_main));
+    kvm_tss_main.iomap = sizeof(kvm_tss_t);
+
+    memset(&kvm_tss_fault, 0, sizeof(kvm_tss_fault));
+    kvm_tss_fault.iomap  = sizeof(kvm_tss_t);
+    kvm_tss_fault.cr3    = (unsigned int)kvm_kernel_dir;
+    kvm_tss_fault.eip    = (unsigned int)kvm_fault_entry;
+    kvm_tss_fault.eflags = 0x2;
+    kvm_tss_fault.esp    = (unsigned int)&kvm_fault_stack[KVM_FAULT_STACK_SIZE];
+    kvm_tss_fault.cs     = get_cs();
+    kvm_tss_fault.ss     = get_ds();
+    kvm_tss_fault.ds     = get_ds();
+    kvm_tss_fault.es     = get_es();
+    kvm_tss_fault.fs     = get_fs();
+    kvm_tss_fault.gs     = get_gs();
+
+    kvm_gdt_set_tss(entries, &kvm_tss_main);
+    kvm_gdt_set_tss(entries + 1, &kvm_tss_fault);
+
+    gdtr.base = (unsigned int)kvm_gdt;
+    gdtr.limit = (entries + 2) * sizeof(kvm_desc_t) - 1;
+    asm volatile("lgdt %0" : : "m"(gdtr));
+
+    // The running task's state is saved to the main TSS on a fault
+    asm volatile("ltr %w0" : : "r"(entries * sizeof(kvm_desc_t)));
+
+    interrupts_task_register(IRQ_PAGE_FAULT, (entries + 1) * sizeof(kvm_desc_t));
+}
+
+/**
+ * Prints the paging statistics to the kernel log
+ */
+void kvm_dump(void) {
+    if (!kvm_enabled()) {
+        return;
+    }
+
+    kernel_log_info("kvm: %d stack pages allocated, %d mapped on first touch, %d copied on write",
+                    kvm_stack_pages, kvm_stack_faults, kvm_cow_copies);
+}
+
+/**
+ * Initializes paging
+ * The kernel image, kernel heap and low memory are identity mapped with
+ * global large pages in every address space
+ */
+void kvm_init(void) {
+    unsigned int features;
+    unsigned int reg;
+
+#if !KVM_PAGING
+    kernel_log_info("kvm: paging is disabled");
+    return;
+#endif
+
+    features = kvm_cpu_features();
+    if ((features & (CPUID_PSE | CPUID_PGE)) != (CPUID_PSE | CPUID_PGE)) {
+        kernel_log_warn("kvm: large or global pages are not supported; paging is disabled");
+        return;
+    }
+
+    kvm_kernel_entries = ((unsigned int)kmem_limit() + KVM_LARGE_SIZE - 1) >> KVM_LARGE_SHIFT;
+
+    kvm_kernel_dir = kmem_page_alloc(0);
+    if (!kvm_kernel_dir) {
+        kernel_panic("kvm: unable to allocate the kernel page directory");
+        return;
+    }
+
+    memset(kvm_kernel_dir, 0, KVM_ENTRIES * sizeof(unsigned int));
+
+    for (int i = 0; i < kvm_kernel_entries; i++) {
+        kvm_kernel_dir[i] = ((unsigned int)i << KVM_LARGE_SHIFT) | KVM_PRESENT | KVM_WRITE | KVM_LARGE | KVM_GLOBAL;
+    }
+
+    kernel_log_info("kvm: mapping %d MB of kernel memory with %d large pages",
+                    kvm_kernel_entries * (KVM_LARGE_SIZE >> 20), kvm_kernel_entries);
+
+    // Enable large and global pages, then turn on paging
+    asm volatile("movl %%cr4, %0" : "=r"(reg));
+    reg |= CR4_PSE | CR4_PGE;
+    asm volatile("movl %0, %%cr4" : : "r"(reg));
+
+    kvm_dir_load(kvm_kernel_dir);
+
+    asm volatile("movl %%cr0, %0" : "=r"(reg));
+    reg |= CR0_PG | CR0_WP;
+    asm volatile("movl %0, %%cr0" : : "r"(reg) : "memory");
+
+    kvm_fault_init();
+}
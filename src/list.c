@@ -0,0 +1,137 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Intrusive doubly-linked list implementation
+ */
+
+#include "list.h"
+
+/**
+ * Initializes an empty list
+ * @param  list - pointer to the list
+ * @return -1 on error; 0 on success
+ */
+int list_init(list_t *list) {
+    if (!list) {
+        return -1;
+    }
+
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+
+    return 0;
+}
+
+/**
+ * Adds a node to the end of a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to add
+ * @return -1 on error; 0 on success
+ */
+int list_append(list_t *list, list_node_t *node) {
+    if (!list || !node) {
+        return -1;
+    }
+
+    node->prev = list->tail;
+    node->next = NULL;
+
+    if (list->tail) {
+        list->tail->next = node;
+    } else {
+        list->head = node;
+    }
+
+    list->tail = node;
+    list->size++;
+
+    return 0;
+}
+
+/**
+ * Adds a node to the beginning of a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to add
+ * @return -1 on error; 0 on success
+ */
+int list_prepend(list_t *list, list_node_t *node) {
+    if (!list || !node) {
+        return -1;
+    }
+
+    node->prev = NULL;
+    node->next = list->head;
+
+    if (list->head) {
+        list->head->prev = node;
+    } else {
+        list->tail = node;
+    }
+
+    list->head = node;
+    list->size++;
+
+    return 0;
+}
+
+/**
+ * Removes a node from a list
+ * @param  list - pointer to the list
+ * @param  node - pointer to the node to remove (must be in the list)
+ * @return -1 on error; 0 on success
+ */
+int list_remove(list_t *list, list_node_t *node) {
+    if (!list || !node || list->size == 0) {
+        return -1;
+    }
+
+    // Unlink the node from its neighbors
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        list->head = node->next;
+    }
+
+    if (node->next) {
+        node->next->prev = node->prev;
+    } else {
+        list->tail = node->prev;
+    }
+
+    node->prev = NULL;
+    node->next = NULL;
+
+    list->size--;
+
+    return 0;
+}
+
+/**
+ * Removes the first node from a list
+ * @param  list - pointer to the list
+ * @return pointer to the node removed, NULL if the list is empty
+ */
+list_node_t *list_pop(list_t *list) {
+    list_node_t *node;
+
+    if (!list || !list->head) {
+        return NULL;
+    }
+
+    node = list->head;
+    list_remove(list, node);
+
+    return node;
+}
+
+/**
+ * Indicates if the list is empty
+ * @param list - pointer to the list
+ * @return true if empty, false if not empty
+ */
+bool list_is_empty(list_t *list) {
+    return !list || list->size == 0;
+}
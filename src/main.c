@@ -19,6 +19,11 @@
 #include "ksyscall.h"
 #include "kmutex.h"
 #include "ksem.h"
+#include "kfutex.h"
+#include "kmem.h"
+#include "kslab.h"
+#include "kvm.h"
+#include "kfpu.h"
 
 int main(void) {
     // Always iniialize the kernel
@@ -30,6 +35,16 @@ int main(void) {
     // Initialize timers
     timer_init();
 
+    // Initialize the kernel heap
+    kmem_init();
+    kmem_caches_init();
+
+    // Initialize paging
+    kvm_init();
+
+    // Initialize lazy FPU switching
+    kfpu_init();
+
     // Initialize the TTY
     tty_init();
 
@@ -43,6 +58,7 @@ int main(void) {
    // kproc_init();
     kmutexes_init();
     ksemaphores_init();
+    kfutex_init();
 
 
     // Initialize the scheduler
@@ -9,6 +9,8 @@
 #include <spede/stdio.h>
 #include <spede/string.h>
 #include "syscall.h"
+#include "tsc.h"
+#include "ulock.h"
 
 #define BUF_SIZE 128
 
@@ -25,11 +27,15 @@
 #define CMD_SLEEP "sleep"
 #define CMD_TIME "time"
 #define CMD_LOCK "lock"
+#define CMD_FORK "fork"
 
 /*
  * Mutexes for the lock
+ * Taken around every input poll, so they are user space mutexes that only
+ * enter the kernel when a shell has to wait; the owner then runs at the
+ * waiting shell's priority until it unlocks
  */
-int shell_mutex[2] = {-1, -1};
+umutex_t shell_mutex[2] = { UMUTEX_INIT, UMUTEX_INIT };
 
 void prog_shell(void) {
     char buf[BUF_SIZE];
@@ -41,10 +47,6 @@ void prog_shell(void) {
 
     int pid = proc_get_pid();
 
-    if (shell_mutex[pid % 2] < 0) {
-        shell_mutex[pid % 2 ] = mutex_init();
-    }
-
     if (proc_get_name(name) != 0) {
         pprintf("error getting process name!");
         proc_exit(-1);
@@ -78,9 +80,14 @@ void prog_shell(void) {
 
         reading = 1;
         while (reading) {
-            mutex_lock(shell_mutex[pid % 2]);
+            // Blocks until there is input
             buflen = io_read(PROC_IO_IN, buf, BUF_SIZE);
+            if (buflen < 0) {
+                pprintf("Unable to read input; exiting process id %d\n", pid);
+                proc_exit(1);
+            }
 
+            umutex_lock(&shell_mutex[pid % 2], pid);
             for (int i = 0; i < buflen; i++) {
                 if (buf[i] == '\n' || buf[i] == 0) {
                     io_write(PROC_IO_OUT, &buf[i], 1);
@@ -90,13 +97,14 @@ void prog_shell(void) {
                     io_write(PROC_IO_OUT, &buf[i], 1);
                 }
             }
-            mutex_unlock(shell_mutex[pid % 2]);
+            umutex_unlock(&shell_mutex[pid % 2], pid);
         }
 
         if (input_len) {
             if (strncmp(input, CMD_HELP, strlen(CMD_HELP)) == 0) {
                 pprintf("Enter one of the following commands:\n");
                 pprintf("\texit\t  exits the process\n");
+                pprintf("\tfork\t  forks a worker that reports and exits\n");
                 pprintf("\tlock\t  takes a lock that may block other shells\n");
                 pprintf("\tsleep\t  puts the process to sleep for %d seconds\n", sleep_seconds);
                 pprintf("\ttime\t  displays the current system time\n");
@@ -110,11 +118,25 @@ void prog_shell(void) {
             } else if (strncmp(input, CMD_EXIT, strlen(CMD_EXIT)) == 0) {
                 pprintf("Exiting process id %d\n", pid);
                 proc_exit(0);
+            } else if (strncmp(input, CMD_FORK, strlen(CMD_FORK)) == 0) {
+                unsigned long long cycles = tsc_read();
+                int child = proc_fork();
+
+                // The worker only uses its copy of the stack; globals are
+                // shared with the shell
+                if (child == 0) {
+                    pprintf("Worker %d forked from shell %d\n", proc_get_pid(), pid);
+                    proc_exit(0);
+                } else if (child < 0) {
+                    pprintf("Unable to fork\n");
+                } else {
+                    pprintf("Forked worker %d in %d cycles\n", child, (int)(tsc_read() - cycles));
+                }
             } else if (strncmp(input, CMD_LOCK, strlen(CMD_LOCK)) == 0) {
                 pprintf("Locking shells for %d seconds\n", sleep_seconds);
-                mutex_lock(shell_mutex[pid % 2]);
+                umutex_lock(&shell_mutex[pid % 2], pid);
                 proc_sleep(sleep_seconds);
-                mutex_unlock(shell_mutex[pid % 2]);
+                umutex_unlock(&shell_mutex[pid % 2], pid);
             } else {
                 pprintf("You entered the following:\n%s\n", input);
             }
@@ -134,7 +156,7 @@ void prog_ping(void) {
     int *pong = &pingpong_semaphores[1];
 
     if (*ping < 0) {
-        *ping = sem_init(1);
+        *ping = sem_init(0);
     }
 
     if (*pong < 0) {
@@ -162,7 +184,7 @@ void prog_pong(void) {
     }
 
     if (*pong < 0) {
-        *pong = sem_init(1);
+        *pong = sem_init(0);
     }
 
     while (1) {
@@ -172,3 +194,473 @@ void prog_pong(void) {
         sem_post(*ping);
     }
 }
+
+/*
+ * Semaphores used for the "pingpong" benchmark
+ */
+int bench_semaphores[2] = {-1, -1};
+
+/**
+ * Ping side of the pingpong benchmark
+ * Bounces between two semaphores as fast as possible
+ */
+void prog_bench_ping(void) {
+    int *ping = &bench_semaphores[0];
+    int *pong = &bench_semaphores[1];
+
+    if (*ping < 0) {
+        *ping = sem_init(0);
+    }
+
+    if (*pong < 0) {
+        *pong = sem_init(0);
+    }
+
+    while (1) {
+        sem_post(*pong);
+        sem_wait(*ping);
+    }
+}
+
+/**
+ * Pong side of the pingpong benchmark
+ * Reports the number of round trips completed each second and the CPU
+ * cycles each one took; a round trip is two context switches
+ */
+void prog_bench_pong(void) {
+    int *ping = &bench_semaphores[0];
+    int *pong = &bench_semaphores[1];
+
+    int rounds = 0;
+    int start;
+    int now;
+    unsigned long long cycles;
+
+    if (*ping < 0) {
+        *ping = sem_init(0);
+    }
+
+    if (*pong < 0) {
+        *pong = sem_init(0);
+    }
+
+    start = sys_get_time();
+    cycles = tsc_read();
+
+    while (1) {
+        sem_wait(*pong);
+        rounds++;
+        sem_post(*ping);
+
+        now = sys_get_time();
+        if (now != start) {
+            pprintf("%04d pingpong: %d round trips/s, %d cycles each\n", now, rounds / (now - start),
+                    (int)((tsc_read() - cycles) / rounds));
+            rounds = 0;
+            start = now;
+            cycles = tsc_read();
+        }
+    }
+}
+
+/**
+ * Child of the spawn benchmark
+ * Exits right away so its process table entry can be reused
+ */
+void prog_bench_spawn_child(void) {
+    proc_exit(0);
+}
+
+/**
+ * Spawn benchmark
+ * Creates processes as fast as possible, yielding to let them exit, and
+ * reports the number created each second and the CPU cycles each
+ * proc_spawn call took
+ */
+void prog_bench_spawn(void) {
+    int spawned = 0;
+    int start;
+    int now;
+    unsigned long long cycles = 0;
+    unsigned long long before;
+
+    start = sys_get_time();
+
+    while (1) {
+        before = tsc_read();
+        if (proc_spawn(prog_bench_spawn_child, "bench_child", PROC_SPAWN_TTY) >= 0) {
+            cycles += tsc_read() - before;
+            spawned++;
+        }
+
+        proc_yield();
+
+        now = sys_get_time();
+        if (now != start && spawned > 0) {
+            pprintf("%04d spawn: %d processes/s, %d cycles each\n", now, spawned / (now - start),
+                    (int)(cycles / spawned));
+            spawned = 0;
+            start = now;
+            cycles = 0;
+        }
+    }
+}
+
+/*
+ * Shared memory and ring buffer throughput benchmarks
+ * Each moves BENCH_CHUNK sized chunks from a producer to a consumer. They
+ * take turns, BENCH_PHASE_SECONDS at a time, so they are not measured
+ * while competing with each other.
+ */
+#define BENCH_CHUNK         4096
+#define BENCH_SLOTS         4
+#define BENCH_PHASE_SECONDS 5
+
+// Shared memory region and semaphores counting its empty and full slots
+int bench_shm = -1;
+int bench_shm_empty = -1;
+int bench_shm_full = -1;
+
+// Sum of the bytes consumed, so the consumers read every byte
+unsigned int bench_checksum;
+
+/**
+ * Sleeps until the given benchmark phase
+ * @param phase - 0 for shared memory, 1 for the ring buffer
+ */
+static void prog_bench_phase_wait(int phase) {
+    while ((sys_get_time() / BENCH_PHASE_SECONDS) % 2 != phase) {
+        proc_sleep(1);
+    }
+}
+
+/**
+ * Adds up a chunk of data
+ * @param buf - data
+ * @param n - number of bytes
+ */
+static void prog_bench_consume(unsigned char *buf, int n) {
+    unsigned int sum = 0;
+
+    for (int i = 0; i < n; i++) {
+        sum += buf[i];
+    }
+
+    bench_checksum += sum;
+}
+
+/**
+ * Reports the throughput once a second
+ * @param name - data path being measured
+ * @param bytes - pointer to the number of bytes moved since the last report
+ * @param start - pointer to the time of the last report
+ */
+static void prog_bench_report(char *name, int *bytes, int *start) {
+    int now = sys_get_time();
+
+    if (now != *start) {
+        if (*bytes > 0) {
+            pprintf("%04d %s: %d KB/s\n", now, name, *bytes / 1024 / (now - *start));
+        }
+
+        *bytes = 0;
+        *start = now;
+    }
+}
+
+/**
+ * Producer side of the shared memory benchmark
+ * Fills the slots of a shared memory region in place
+ */
+void prog_bench_shm_producer(void) {
+    unsigned char *mem;
+    int slot = 0;
+
+    bench_shm_empty = sem_init(BENCH_SLOTS);
+    bench_shm_full = sem_init(0);
+    bench_shm = shm_create(BENCH_CHUNK * BENCH_SLOTS);
+
+    mem = shm_attach(bench_shm);
+    if (!mem) {
+        pprintf("shm: unable to create the shared memory region\n");
+        proc_exit(-1);
+    }
+
+    while (1) {
+        prog_bench_phase_wait(0);
+
+        sem_wait(bench_shm_empty);
+        memset(&mem[slot * BENCH_CHUNK], slot + 1, BENCH_CHUNK);
+        sem_post(bench_shm_full);
+
+        slot = (slot + 1) % BENCH_SLOTS;
+    }
+}
+
+/**
+ * Consumer side of the shared memory benchmark
+ * Reads the slots of the shared memory region in place
+ */
+void prog_bench_shm_consumer(void) {
+    unsigned char *mem;
+    int slot = 0;
+    int bytes = 0;
+    int start = sys_get_time();
+
+    while (bench_shm < 0) {
+        proc_yield();
+    }
+
+    mem = shm_attach(bench_shm);
+    if (!mem) {
+        pprintf("shm: unable to attach the shared memory region\n");
+        proc_exit(-1);
+    }
+
+    while (1) {
+        sem_wait(bench_shm_full);
+        prog_bench_consume(&mem[slot * BENCH_CHUNK], BENCH_CHUNK);
+        sem_post(bench_shm_empty);
+
+        slot = (slot + 1) % BENCH_SLOTS;
+        bytes += BENCH_CHUNK;
+
+        prog_bench_report("shm", &bytes, &start);
+    }
+}
+
+/**
+ * Producer side of the ring buffer benchmark
+ * Fills a chunk and writes it to the PROC_IO_AUX ring buffer
+ */
+void prog_bench_ringbuf_producer(void) {
+    unsigned char buf[BENCH_CHUNK];
+    int slot = 0;
+
+    while (1) {
+        prog_bench_phase_wait(1);
+
+        memset(buf, slot + 1, BENCH_CHUNK);
+
+        // Blocks while the ring buffer is full
+        if (io_write(PROC_IO_AUX, (char *)buf, BENCH_CHUNK) < 0) {
+            pprintf("ringbuf: unable to write the ring buffer\n");
+            proc_exit(-1);
+        }
+
+        slot = (slot + 1) % BENCH_SLOTS;
+    }
+}
+
+/**
+ * Consumer side of the ring buffer benchmark
+ * Reads chunks from the PROC_IO_AUX ring buffer
+ */
+void prog_bench_ringbuf_consumer(void) {
+    unsigned char buf[BENCH_CHUNK];
+    int bytes = 0;
+    int start = sys_get_time();
+    int n;
+
+    while (1) {
+        // Blocks until the producer writes, like the shared memory
+        // consumer blocks on its semaphore
+        n = io_read(PROC_IO_AUX, (char *)buf, BENCH_CHUNK);
+        if (n < 0) {
+            pprintf("ringbuf: unable to read the ring buffer\n");
+            proc_exit(-1);
+        }
+
+        prog_bench_consume(buf, n);
+        bytes += n;
+
+        prog_bench_report("ringbuf", &bytes, &start);
+    }
+}
+
+/**
+ * FPU benchmark
+ * Accumulates in floating point while other processes run, checking the
+ * result each step so a lost FPU state shows up as an error, and reports
+ * the number of steps each second
+ */
+void prog_bench_fpu(void) {
+    int pid = proc_get_pid();
+    int steps = 0;
+    int errors = 0;
+    int start = sys_get_time();
+    int now;
+    double value = 0;
+
+    while (1) {
+        value += 0.5;
+        steps++;
+
+        if (value != steps * 0.5) {
+            errors++;
+            value = steps * 0.5;
+        }
+
+        if ((steps & 0xffff) == 0) {
+            now = sys_get_time();
+            if (now != start) {
+                pprintf("%04d fpu[%02d]: %d steps/s, %d errors\n", now, pid, steps / (now - start), errors);
+                steps = 0;
+                value = 0;
+                start = now;
+            }
+        }
+    }
+}
+
+/*
+ * Lock benchmark
+ * Times uncontended lock/unlock and wait/post pairs through the user space
+ * locks and through the system call locks
+ */
+#define BENCH_LOCK_ROUNDS 10000
+
+umutex_t bench_umutex = UMUTEX_INIT;
+usem_t bench_usem = USEM_INIT(0);
+
+/**
+ * Lock benchmark
+ * Reports the CPU cycles of each kind of pair every 10 seconds
+ */
+void prog_bench_lock(void) {
+    int pid = proc_get_pid();
+    int mutex = mutex_init();
+    int sem = sem_init(0);
+    unsigned long long start;
+    int umutex_cycles;
+    int mutex_cycles;
+    int usem_cycles;
+    int sem_cycles;
+
+    while (1) {
+        start = tsc_read();
+        for (int i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+            umutex_lock(&bench_umutex, pid);
+            umutex_unlock(&bench_umutex, pid);
+        }
+        umutex_cycles = (int)((tsc_read() - start) / BENCH_LOCK_ROUNDS);
+
+        start = tsc_read();
+        for (int i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+            mutex_lock(mutex);
+            mutex_unlock(mutex);
+        }
+        mutex_cycles = (int)((tsc_read() - start) / BENCH_LOCK_ROUNDS);
+
+        start = tsc_read();
+        for (int i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+            usem_post(&bench_usem);
+            usem_wait(&bench_usem);
+        }
+        usem_cycles = (int)((tsc_read() - start) / BENCH_LOCK_ROUNDS);
+
+        start = tsc_read();
+        for (int i = 0; i < BENCH_LOCK_ROUNDS; i++) {
+            sem_post(sem);
+            sem_wait(sem);
+        }
+        sem_cycles = (int)((tsc_read() - start) / BENCH_LOCK_ROUNDS);
+
+        pprintf("%04d locks: mutex %d cycles (syscall %d), semaphore %d cycles (syscall %d)\n",
+                sys_get_time(), umutex_cycles, mutex_cycles, usem_cycles, sem_cycles);
+
+        proc_sleep(10);
+    }
+}
+
+/*
+ * Pipe throughput benchmark
+ * Moves BENCH_PIPE_BYTES through a pipe to a spawned consumer for each of
+ * the pipe sizes in turn
+ */
+#define BENCH_PIPE_BYTES    (64 * 1024)
+#define BENCH_PIPE_WRITE    1024
+
+int bench_pipe_sizes[] = { 64, 256, 1024, 2048 };
+
+// Ends of the pipe being measured; passed to the consumer
+int bench_pipe_ends[2];
+
+// Number of bytes the consumer read before the end of the pipe
+int bench_pipe_received;
+
+// Posted by the consumer once it has reached the end of the pipe
+usem_t bench_pipe_done = USEM_INIT(0);
+
+/**
+ * Consumer side of the pipe benchmark
+ * Reads from the pipe until its end and exits
+ */
+void prog_bench_pipe_consumer(void) {
+    unsigned char buf[BENCH_PIPE_WRITE];
+    int bytes = 0;
+    int n;
+
+    // Only the producer writes; the end of the pipe is seen once it closes
+    // its write end
+    io_close(bench_pipe_ends[1]);
+
+    while ((n = io_read(bench_pipe_ends[0], (char *)buf, BENCH_PIPE_WRITE)) > 0) {
+        prog_bench_consume(buf, n);
+        bytes += n;
+    }
+
+    bench_pipe_received = bytes;
+    usem_post(&bench_pipe_done);
+    proc_exit(0);
+}
+
+/**
+ * Pipe benchmark
+ * Reports the CPU cycles per KB moved through each pipe size every 10 seconds
+ */
+void prog_bench_pipe(void) {
+    char buf[BENCH_PIPE_WRITE];
+    unsigned long long start;
+    int cycles;
+    int size;
+
+    memset(buf, 0xa5, sizeof(buf));
+
+    while (1) {
+        for (int i = 0; i < (int)(sizeof(bench_pipe_sizes) / sizeof(bench_pipe_sizes[0])); i++) {
+            size = bench_pipe_sizes[i];
+
+            if (pipe(bench_pipe_ends, size) != 0) {
+                pprintf("%04d pipe: unable to create a %d byte pipe\n", sys_get_time(), size);
+                break;
+            }
+
+            start = tsc_read();
+
+            if (proc_spawn(prog_bench_pipe_consumer, "bench_pipe_rx", PROC_SPAWN_PIPES) < 0) {
+                pprintf("%04d pipe: unable to spawn the consumer\n", sys_get_time());
+                io_close(bench_pipe_ends[0]);
+                io_close(bench_pipe_ends[1]);
+                continue;
+            }
+
+            // Only the consumer reads
+            io_close(bench_pipe_ends[0]);
+
+            for (int sent = 0; sent < BENCH_PIPE_BYTES; sent += BENCH_PIPE_WRITE) {
+                io_write(bench_pipe_ends[1], buf, BENCH_PIPE_WRITE);
+            }
+
+            // Closing the write end ends the pipe for the consumer
+            io_close(bench_pipe_ends[1]);
+            usem_wait(&bench_pipe_done);
+
+            cycles = (int)((tsc_read() - start) / (BENCH_PIPE_BYTES / 1024));
+            pprintf("%04d pipe: %d byte pipe, %d cycles/KB, %d of %d bytes received\n", sys_get_time(),
+                    size, cycles, bench_pipe_received, BENCH_PIPE_BYTES);
+        }
+
+        proc_sleep(10);
+    }
+}
@@ -0,0 +1,378 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Intrusive red-black tree implementation
+ */
+
+#include "rbtree.h"
+
+/**
+ * Replaces the child of a parent node (or the root)
+ * @param tree - pointer to the tree
+ * @param parent - parent node, NULL if the child is the root
+ * @param old - the child being replaced
+ * @param new - the replacement child
+ */
+static void rbtree_replace(rbtree_t *tree, rbtree_node_t *parent,
+                           rbtree_node_t *old, rbtree_node_t *new) {
+    if (!parent) {
+        tree->root = new;
+    } else if (parent->left == old) {
+        parent->left = new;
+    } else {
+        parent->right = new;
+    }
+
+    if (new) {
+        new->parent = parent;
+    }
+}
+
+/**
+ * Rotates a node to the left; its right child takes its place
+ * @param tree - pointer to the tree
+ * @param node - pointer to the node to rotate
+ */
+static void rbtree_rotate_left(rbtree_t *tree, rbtree_node_t *node) {
+    rbtree_node_t *child = node->right;
+
+    node->right = child->left;
+    if (child->left) {
+        child->left->parent = node;
+    }
+
+    rbtree_replace(tree, node->parent, node, child);
+
+    child->left = node;
+    node->parent = child;
+}
+
+/**
+ * Rotates a node to the right; its left child takes its place
+ * @param tree - pointer to the tree
+ * @param node - pointer to the node to rotate
+ */
+static void rbtree_rotate_right(rbtree_t *tree, rbtree_node_t *node) {
+    rbtree_node_t *child = node->left;
+
+    node->left = child->right;
+    if (child->right) {
+        child->right->parent = node;
+    }
+
+    rbtree_replace(tree, node->parent, node, child);
+
+    child->right = node;
+    node->parent = child;
+}
+
+/**
+ * Indicates if a node is red; empty leaves are black
+ * @param node - pointer to the node
+ * @return non-zero if red
+ */
+static int rbtree_is_red(rbtree_node_t *node) {
+    return node && node->red;
+}
+
+/**
+ * Initializes an empty tree
+ * @param  tree - pointer to the tree
+ * @return -1 on error; 0 on success
+ */
+int rbtree_init(rbtree_t *tree) {
+    if (!tree) {
+        return -1;
+    }
+
+    tree->root = NULL;
+    tree->first = NULL;
+    tree->size = 0;
+
+    return 0;
+}
+
+/**
+ * Inserts a node into a tree
+ * Nodes that compare equal are placed after the existing ones
+ * @param  tree - pointer to the tree
+ * @param  node - pointer to the node to insert
+ * @param  before - ordering function
+ * @return -1 on error; 0 on success
+ */
+int rbtree_insert(rbtree_t *tree, rbtree_node_t *node, rbtree_before_t before) {
+    rbtree_node_t *parent = NULL;
+    rbtree_node_t **link;
+    rbtree_node_t *uncle;
+    rbtree_node_t *grandparent;
+    int leftmost = 1;
+
+    if (!tree || !node || !before) {
+        return -1;
+    }
+
+    // Walk down to the leaf position for the node
+    link = &tree->root;
+    while (*link) {
+        parent = *link;
+
+        if (before(node, parent)) {
+            link = &parent->left;
+        } else {
+            link = &parent->right;
+            leftmost = 0;
+        }
+    }
+
+    node->parent = parent;
+    node->left = NULL;
+    node->right = NULL;
+    node->red = 1;
+    *link = node;
+
+    if (leftmost) {
+        tree->first = node;
+    }
+
+    tree->size++;
+
+    // Restore the red-black properties; a red node may not have a red parent
+    while (rbtree_is_red(node->parent)) {
+        parent = node->parent;
+        grandparent = parent->parent;
+
+        if (parent == grandparent->left) {
+            uncle = grandparent->right;
+
+            if (rbtree_is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->right) {
+                rbtree_rotate_left(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = 0;
+            grandparent->red = 1;
+            rbtree_rotate_right(tree, grandparent);
+        } else {
+            uncle = grandparent->left;
+
+            if (rbtree_is_red(uncle)) {
+                parent->red = 0;
+                uncle->red = 0;
+                grandparent->red = 1;
+                node = grandparent;
+                continue;
+            }
+
+            if (node == parent->left) {
+                rbtree_rotate_right(tree, parent);
+                node = parent;
+                parent = node->parent;
+            }
+
+            parent->red = 0;
+            grandparent->red = 1;
+            rbtree_rotate_left(tree, grandparent);
+        }
+    }
+
+    tree->root->red = 0;
+
+    return 0;
+}
+
+/**
+ * Removes a node from a tree
+ * @param  tree - pointer to the tree
+ * @param  node - pointer to the node to remove (must be in the tree)
+ * @return -1 on error; 0 on success
+ */
+int rbtree_remove(rbtree_t *tree, rbtree_node_t *node) {
+    rbtree_node_t *child;
+    rbtree_node_t *parent;
+    rbtree_node_t *sibling;
+    rbtree_node_t *next;
+    int red;
+
+    if (!tree || !node || tree->size == 0) {
+        return -1;
+    }
+
+    if (tree->first == node) {
+        tree->first = rbtree_next(node);
+    }
+
+    if (!node->left || !node->right) {
+        // At most one child; it takes the place of the node
+        child = node->left ? node->left : node->right;
+        parent = node->parent;
+        red = node->red;
+
+        rbtree_replace(tree, parent, node, child);
+    } else {
+        // Two children; the next node in order takes the place of the node
+        next = node->right;
+        while (next->left) {
+            next = next->left;
+        }
+
+        child = next->right;
+        red = next->red;
+
+        if (next->parent == node) {
+            parent = next;
+        } else {
+            parent = next->parent;
+
+            rbtree_replace(tree, parent, next, child);
+
+            next->right = node->right;
+            next->right->parent = next;
+        }
+
+        rbtree_replace(tree, node->parent, node, next);
+
+        next->left = node->left;
+        next->left->parent = next;
+        next->red = node->red;
+    }
+
+    node->parent = NULL;
+    node->left = NULL;
+    node->right = NULL;
+
+    tree->size--;
+
+    // Removing a red node keeps the black heights intact
+    if (red) {
+        return 0;
+    }
+
+    // Restore the black height along the path of the removed black node
+    while (child != tree->root && !rbtree_is_red(child)) {
+        if (child == parent->left) {
+            sibling = parent->right;
+
+            if (rbtree_is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rbtree_rotate_left(tree, parent);
+                sibling = parent->right;
+            }
+
+            if (!rbtree_is_red(sibling->left) && !rbtree_is_red(sibling->right)) {
+                sibling->red = 1;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+
+            if (!rbtree_is_red(sibling->right)) {
+                sibling->left->red = 0;
+                sibling->red = 1;
+                rbtree_rotate_right(tree, sibling);
+                sibling = parent->right;
+            }
+
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->right->red = 0;
+            rbtree_rotate_left(tree, parent);
+            child = tree->root;
+        } else {
+            sibling = parent->left;
+
+            if (rbtree_is_red(sibling)) {
+                sibling->red = 0;
+                parent->red = 1;
+                rbtree_rotate_right(tree, parent);
+                sibling = parent->left;
+            }
+
+            if (!rbtree_is_red(sibling->left) && !rbtree_is_red(sibling->right)) {
+                sibling->red = 1;
+                child = parent;
+                parent = child->parent;
+                continue;
+            }
+
+            if (!rbtree_is_red(sibling->left)) {
+                sibling->right->red = 0;
+                sibling->red = 1;
+                rbtree_rotate_left(tree, sibling);
+                sibling = parent->left;
+            }
+
+            sibling->red = parent->red;
+            parent->red = 0;
+            sibling->left->red = 0;
+            rbtree_rotate_right(tree, parent);
+            child = tree->root;
+        }
+    }
+
+    if (child) {
+        child->red = 0;
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the first (leftmost) node of a tree
+ * @param  tree - pointer to the tree
+ * @return pointer to the first node, NULL if the tree is empty
+ */
+rbtree_node_t *rbtree_first(rbtree_t *tree) {
+    if (!tree) {
+        return NULL;
+    }
+
+    return tree->first;
+}
+
+/**
+ * Returns the node that follows a node in tree order
+ * @param  node - pointer to a node in the tree
+ * @return pointer to the next node, NULL if it is the last node
+ */
+rbtree_node_t *rbtree_next(rbtree_node_t *node) {
+    if (!node) {
+        return NULL;
+    }
+
+    // The next node is the leftmost node of the right subtree
+    if (node->right) {
+        node = node->right;
+        while (node->left) {
+            node = node->left;
+        }
+        return node;
+    }
+
+    // Otherwise it is the first ancestor reached from a left subtree
+    while (node->parent && node == node->parent->right) {
+        node = node->parent;
+    }
+
+    return node->parent;
+}
+
+/**
+ * Indicates if the tree is empty
+ * @param tree - pointer to the tree
+ * @return true if empty, false if not empty
+ */
+bool rbtree_is_empty(rbtree_t *tree) {
+    return !tree || tree->size == 0;
+}
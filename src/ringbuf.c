@@ -10,8 +10,12 @@
 #include <spede/stddef.h>       // for size_t
 #include <spede/string.h>       // for memset
 
+#include "kslab.h"
 #include "ringbuf.h"
 
+// Ring buffer cache
+kmem_cache_t ringbuf_cache = KMEM_CACHE("ringbuf", sizeof(ringbuf_t), 2, 0);
+
 /**
  * Initializes an empty ring buffer
  * Sets the empty data to 0
@@ -24,11 +28,38 @@ int ringbuf_init(ringbuf_t *buf) {
         return -1;
     }
 
-    memset(buf, 0, RINGBUF_SIZE);
+    ringbuf_flush(buf);
+    list_init(&buf->readers);
+    list_init(&buf->writers);
+    buf->capacity = RINGBUF_SIZE;
+    buf->read_ends = 0;
+    buf->write_ends = 0;
 
     return 0;
 }
 
+/**
+ * Allocates an empty ring buffer from the kernel heap
+ * @return pointer to the ring buffer, NULL if no memory is available
+ */
+ringbuf_t *ringbuf_alloc(void) {
+    ringbuf_t *buf = kmem_cache_alloc(&ringbuf_cache);
+
+    if (buf) {
+        ringbuf_init(buf);
+    }
+
+    return buf;
+}
+
+/**
+ * Returns a ring buffer to the kernel heap
+ * @param buf - pointer to the ring buffer structure
+ */
+void ringbuf_free(ringbuf_t *buf) {
+    kmem_cache_free(&ringbuf_cache, buf);
+}
+
 /**
  * Writes a byte to the buffer
  * @param  buf   - pointer to the ring buffer structure
@@ -40,7 +71,7 @@ int ringbuf_write(ringbuf_t *buf, char byte) {
         return -1;
     }
 
-    if (buf->size == RINGBUF_SIZE) {
+    if (buf->size >= buf->capacity) {
         return -1;
     }
 
@@ -99,7 +130,7 @@ int ringbuf_write_mem(ringbuf_t *buf, char *mem, size_t size) {
         return -1;
     }
 
-    if (buf->size + size > RINGBUF_SIZE) {
+    if (buf->size + size > (size_t)buf->capacity) {
         return -1;
     }
 
@@ -110,6 +141,28 @@ int ringbuf_write_mem(ringbuf_t *buf, char *mem, size_t size) {
     return 0;
 }
 
+/**
+ * Copies as many bytes to the buffer from the specified memory as fit
+ * @param buf - pointer to the ring buffer structure
+ * @param mem - pointer to the memory location to copy from
+ * @param size - number of bytes to copy
+ * @return -1 on error, otherwise the number of bytes copied
+ */
+int ringbuf_write_partial(ringbuf_t *buf, char *mem, size_t size) {
+    if (!buf) {
+        return -1;
+    }
+
+    int count = 0;
+
+    while (size-- && !ringbuf_is_full(buf)) {
+        ringbuf_write(buf, *mem++);
+        count++;
+    }
+
+    return count;
+}
+
 /**
  * Copies multiple bytes from the buffer to the specified memory
  * @param buf - pointer to the ring buffer structure
@@ -143,7 +196,13 @@ int ringbuf_flush(ringbuf_t *buf) {
         return -1;
     }
 
-    memset(buf, 0, RINGBUF_SIZE);
+    // Only the data is reset; processes waiting on the buffer and its
+    // capacity are kept
+    buf->head = 0;
+    buf->tail = 0;
+    buf->size = 0;
+    memset(buf->data, 0, sizeof(buf->data));
+
     return 0;
 }
 
@@ -162,6 +221,6 @@ bool ringbuf_is_empty(ringbuf_t *buf) {
  * @return true if full, false if not full
  */
 bool ringbuf_is_full(ringbuf_t *buf) {
-    return buf && buf->size == RINGBUF_SIZE;
+    return buf && buf->size >= buf->capacity;
 }
 
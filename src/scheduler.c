@@ -14,46 +14,188 @@
 #include "kernel.h"
 #include "kproc.h"
 #include "scheduler.h"
+#include "scheduler_class.h"
 #include "timer.h"
 
-#include "queue.h"
+#include "list.h"
 
-// Process Queues
-queue_t run_queue;      // Run queue -> processes that will be scheduled to run
-queue_t sleep_queue;    // Sleep queue -> processes that are currently sleeping
+// Sleep queue -> min-heap of sleeping processes ordered by wake up tick
+proc_t *sleep_queue[PROC_MAX];
+int sleep_queue_size;
+
+// Best-effort scheduling classes that may be selected
+static scheduler_class_t *scheduler_classes[] = {
+    &scheduler_class_mlfq,
+    &scheduler_class_cfs,
+    NULL
+};
+
+// Best-effort class that processes not assigned a class are scheduled by
+scheduler_class_t *scheduler_class;
+
+/**
+ * Returns the scheduling class of a process
+ * @param proc - pointer to the process entry
+ * @return pointer to the scheduling class
+ */
+scheduler_class_t *scheduler_class_of(proc_t *proc) {
+    return proc->sched_class ? proc->sched_class : scheduler_class;
+}
+
+/**
+ * Accounts for a process giving up the CPU to block (sleep or wait)
+ * @param proc - pointer to the process entry
+ */
+static void scheduler_release(proc_t *proc) {
+    scheduler_class_t *class;
+
+    if (proc != active_proc) {
+        return;
+    }
+
+    proc->switches_voluntary++;
+
+    class = scheduler_class_of(proc);
+    if (class->release) {
+        class->release(proc);
+    }
+}
+
+/**
+ * Indicates if a sleeping process wakes up before another one
+ * Compares the difference so the result holds when the tick count wraps
+ * @param a - pointer to the first process entry
+ * @param b - pointer to the second process entry
+ * @return non-zero if a wakes up before b
+ */
+static int sleep_queue_before(proc_t *a, proc_t *b) {
+    return (a->wake_time - b->wake_time) < 0;
+}
+
+/**
+ * Places a process at a position in the sleep queue
+ * @param proc - pointer to the process entry
+ * @param index - position in the sleep queue
+ */
+static void sleep_queue_set(proc_t *proc, int index) {
+    sleep_queue[index] = proc;
+    proc->sleep_index = index;
+}
+
+/**
+ * Moves the process at the given position towards the head of the sleep
+ * queue until it no longer wakes up before its parent
+ * @param index - position in the sleep queue
+ */
+static void sleep_queue_up(int index) {
+    proc_t *proc = sleep_queue[index];
+
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+
+        if (!sleep_queue_before(proc, sleep_queue[parent])) {
+            break;
+        }
+
+        sleep_queue_set(sleep_queue[parent], index);
+        index = parent;
+    }
+
+    sleep_queue_set(proc, index);
+}
+
+/**
+ * Moves the process at the given position towards the tail of the sleep
+ * queue until none of its children wake up before it
+ * @param index - position in the sleep queue
+ */
+static void sleep_queue_down(int index) {
+    proc_t *proc = sleep_queue[index];
+
+    while (1) {
+        int child = index * 2 + 1;
+
+        if (child >= sleep_queue_size) {
+            break;
+        }
+
+        // Follow the child that wakes up first
+        if (child + 1 < sleep_queue_size && sleep_queue_before(sleep_queue[child + 1], sleep_queue[child])) {
+            child++;
+        }
+
+        if (!sleep_queue_before(sleep_queue[child], proc)) {
+            break;
+        }
+
+        sleep_queue_set(sleep_queue[child], index);
+        index = child;
+    }
+
+    sleep_queue_set(proc, index);
+}
+
+/**
+ * Adds a process to the sleep queue
+ * @param proc - pointer to the process entry
+ */
+static void sleep_queue_in(proc_t *proc) {
+    if (sleep_queue_size >= PROC_MAX) {
+        kernel_panic("Unable to add the process to the sleep queue");
+    }
+
+    sleep_queue_set(proc, sleep_queue_size++);
+    sleep_queue_up(proc->sleep_index);
+}
+
+/**
+ * Removes a process from the sleep queue
+ * @param proc - pointer to the process entry
+ */
+static void sleep_queue_remove(proc_t *proc) {
+    int index = proc->sleep_index;
+
+    if (index < 0 || index >= sleep_queue_size || sleep_queue[index] != proc) {
+        kernel_panic("Process %d is not in the sleep queue", proc->pid);
+    }
+
+    proc->sleep_index = -1;
+
+    // Fill the hole with the last process and restore the heap order
+    if (--sleep_queue_size == index) {
+        return;
+    }
+
+    sleep_queue_set(sleep_queue[sleep_queue_size], index);
+    sleep_queue_down(index);
+    sleep_queue_up(sleep_queue[index]->sleep_index);
+}
 
 /**
  * Scheduler timer callback
  */
 void scheduler_timer(void) {
-    int pid;
+    int now = timer_get_ticks();
+    scheduler_class_t *class;
     proc_t *proc;
 
     // Update the active process' run time and CPU time
     if (active_proc) {
         active_proc->run_time++;
         active_proc->cpu_time++;
-    }
 
-    for (int i = 0; i < sleep_queue.size; i++) {
-        pid = -1;
-
-        if (queue_out(&sleep_queue, &pid) != 0) {
-            kernel_log_warn("Unable to queue out of sleep queue");
-            continue;
-        }
-
-        proc = pid_to_proc(pid);
-        if (!proc) {
-            kernel_log_warn("Unable to look up process id %d", pid);
-            continue;
+        class = scheduler_class_of(active_proc);
+        if (class->tick) {
+            class->tick(active_proc);
         }
+    }
 
-        if (proc->sleep_time-- >= 0) {
-            queue_in(&sleep_queue, pid);
-        } else {
-            scheduler_add(proc);
-        }
+    // Wake up processes from the head of the sleep queue until
+    // one is found that still needs to sleep
+    while (sleep_queue_size > 0 && (sleep_queue[0]->wake_time - now) <= 0) {
+        proc = sleep_queue[0];
+        sleep_queue_remove(proc);
+        scheduler_add(proc);
     }
 }
 
@@ -62,7 +204,10 @@ void scheduler_timer(void) {
  * Should ensure that `active_proc` is set to a valid process entry
  */
 void scheduler_run(void) {
-    int pid;
+    scheduler_class_t *class;
+    int quantum;
+    int expired;
+    int preempt;
 
     // Ensure that processes not in the active state aren't still scheduled
     if (active_proc && active_proc->state != ACTIVE) {
@@ -71,11 +216,29 @@ void scheduler_run(void) {
 
     // Check if we have an active process
     if (active_proc) {
-        // Check if the current process has exceeded it's time slice
-        if (active_proc->cpu_time >= SCHEDULER_TIMESLICE) {
+        class = scheduler_class_of(active_proc);
+
+        // Check if the current process has exceeded it's time slice or if
+        // a process that should run ahead of it is ready to run
+        // Ready real-time processes run ahead of all best-effort processes
+        quantum = class->quantum(active_proc);
+        expired = quantum > 0 && active_proc->cpu_time >= quantum;
+
+        preempt = scheduler_class_rt.preempt(active_proc);
+        if (!preempt && class != &scheduler_class_rt) {
+            preempt = scheduler_class->preempt(active_proc);
+        }
+
+        if (expired || preempt) {
             // Reset the active time
             active_proc->cpu_time = 0;
 
+            if (expired && class->expire) {
+                class->expire(active_proc);
+            }
+
+            active_proc->switches_involuntary++;
+
             // If the process is not the idle task, add it back to the scheduler
             // Otherwise, simply set the state to IDLE
 
@@ -94,14 +257,22 @@ void scheduler_run(void) {
 
     // Check if we have a process scheduled or not
     if (!active_proc) {
-        // Get the proces id from the run queue
-        if (queue_out(&run_queue, &pid) != 0) {
-            // default to process id 0 (idle task)
-            pid = 0;
+        // Get the next real-time process, otherwise the next
+        // best-effort process
+        active_proc = scheduler_class_rt.pick_next();
+
+        if (!active_proc) {
+            active_proc = scheduler_class->pick_next();
+        }
+
+        // default to process id 0 (idle task)
+        if (!active_proc) {
+            active_proc = pid_to_proc(0);
         }
 
-        active_proc = pid_to_proc(pid);
-        kernel_log_trace("Scheduling process pid=%d, name=%s", active_proc->pid, active_proc->name);
+        if (active_proc) {
+            kernel_log_trace("Scheduling process pid=%d, name=%s", active_proc->pid, active_proc->name);
+        }
     }
 
     // Make sure we have a valid process at this point
@@ -118,17 +289,24 @@ void scheduler_run(void) {
  * @param proc - pointer to the process entry
  */
 void scheduler_add(proc_t *proc) {
+    scheduler_class_t *class;
+
     if (!proc) {
         kernel_panic("Invalid process!");
     }
 
-    proc->scheduler_queue = &run_queue;
+    class = scheduler_class_of(proc);
+
+    // Processes that were not running are becoming ready after being
+    // created, sleeping or waiting
+    if (proc->state != ACTIVE && class->wake) {
+        class->wake(proc);
+    }
+
     proc->state = IDLE;
     proc->cpu_time = 0;
 
-    if (queue_in(proc->scheduler_queue, proc->pid) != 0) {
-        kernel_panic("Unable to add the process to the scheduler");
-    }
+    class->enqueue(proc);
 }
 
 /**
@@ -136,29 +314,21 @@ void scheduler_add(proc_t *proc) {
  * @param proc - pointer to the process entry
  */
 void scheduler_remove(proc_t *proc) {
-    int pid;
-
     if (!proc) {
         kernel_panic("Invalid process!");
         exit(1);
     }
 
-    if (proc->scheduler_queue) {
-        for (int i = 0; i < proc->scheduler_queue->size; i++) {
-            if (queue_out(proc->scheduler_queue, &pid) != 0) {
-                kernel_panic("Unable to queue out the process entry");
-            }
-
-            if (proc->pid == pid) {
-                // Found the process
-                // continue iterating so the run queue order is maintained
-                continue;
-            }
+    if (proc->state == SLEEPING) {
+        sleep_queue_remove(proc);
+    }
 
-            // Add the item back to the run queue
-            if (queue_in(proc->scheduler_queue, pid) != 0) {
-                kernel_panic("Unable to queue process back to the run queue");
-            }
+    if (proc->on_run_queue) {
+        scheduler_class_of(proc)->dequeue(proc);
+    } else if (proc->scheduler_queue) {
+        // Unlink the process; the rest of the queue order is maintained
+        if (list_remove(proc->scheduler_queue, &proc->scheduler_node) != 0) {
+            kernel_panic("Unable to remove the process from its queue");
         }
 
         // Set the queue to NULL since it does not exist in a queue any longer
@@ -178,17 +348,319 @@ void scheduler_sleep(proc_t *proc, int time) {
         return;
     }
 
-    proc->sleep_time = time;
-    if (proc->state == SLEEPING) {
+    scheduler_release(proc);
+    scheduler_remove(proc);
+
+    // Sleep until an absolute tick so the timer only needs to check
+    // the head of the sleep queue
+    proc->wake_time = timer_get_ticks() + time;
+    proc->state = SLEEPING;
+
+    sleep_queue_in(proc);
+}
+
+/**
+ * Takes a process out of its run queue until a given tick
+ * If the tick has already passed the process is added back to the scheduler
+ * @param proc - pointer to the process entry
+ * @param tick - timer tick to wake up at
+ */
+void scheduler_suspend(proc_t *proc, int tick) {
+    if (!proc) {
+        kernel_panic("Invalid process");
         return;
     }
 
     scheduler_remove(proc);
 
-    proc->state = SLEEPING;
-    proc->scheduler_queue = &sleep_queue;
+    if ((tick - timer_get_ticks()) > 0) {
+        proc->wake_time = tick;
+        proc->state = SLEEPING;
+
+        sleep_queue_in(proc);
+    } else {
+        scheduler_add(proc);
+    }
+}
+
+/**
+ * Yields the CPU; the process is placed at the end of its run queue
+ * @param proc - pointer to the process entry
+ */
+void scheduler_yield(proc_t *proc) {
+    scheduler_class_t *class;
+    int cpu_time;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return;
+    }
+
+    // The idle task is never queued; it is scheduled when nothing else is ready
+    if (proc->pid == 0) {
+        return;
+    }
+
+    // Yielding is a voluntary switch, but it is not blocking: the class is
+    // not told the CPU was released, so a process can not keep a high
+    // feedback level by yielding just before its time slice expires
+    if (proc == active_proc) {
+        proc->switches_voluntary++;
+    }
+
+    class = scheduler_class_of(proc);
+    if (class->yield) {
+        class->yield(proc);
+        return;
+    }
+
+    // The time slice is not renewed by yielding; the process expires once
+    // it has used the whole slice, however often it yields
+    cpu_time = proc->cpu_time;
+
+    scheduler_remove(proc);
+    scheduler_add(proc);
+
+    proc->cpu_time = cpu_time;
+}
+
+/**
+ * Blocks a process on a wait queue
+ * The process is removed from the scheduler until it is woken up
+ * @param proc - pointer to the process entry
+ * @param queue - pointer to the wait queue
+ */
+void scheduler_wait(proc_t *proc, list_t *queue) {
+    if (!proc || !queue) {
+        kernel_panic("Invalid process or wait queue");
+        return;
+    }
+
+    scheduler_release(proc);
+    scheduler_remove(proc);
+
+    proc->state = WAITING;
+    proc->scheduler_queue = queue;
+
+    if (list_append(queue, &proc->scheduler_node) != 0) {
+        kernel_panic("Unable to add the process to the wait queue");
+    }
+}
+
+/**
+ * Wakes up the first process waiting on a wait queue
+ * The process is added back to the scheduler
+ * @param queue - pointer to the wait queue
+ * @return pointer to the process entry woken up, NULL if none were waiting
+ */
+proc_t *scheduler_wake(list_t *queue) {
+    list_node_t *node;
+    proc_t *proc;
+
+    node = list_pop(queue);
+    if (!node) {
+        return NULL;
+    }
+
+    proc = list_entry(node, proc_t, scheduler_node);
+    proc->scheduler_queue = NULL;
+
+    scheduler_add(proc);
+
+    return proc;
+}
+
+/**
+ * Hands the rest of the active process' time slice to a process that is
+ * ready to run, which is switched in when the kernel context is exited
+ * The active process is added back to the scheduler
+ * @param proc - pointer to the process entry to switch to
+ */
+void scheduler_handoff(proc_t *proc) {
+    proc_t *donor = active_proc;
+    int remaining;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return;
+    }
+
+    // Only hand off from a running process to one waiting in a run queue
+    // Both must be best-effort; real-time processes are scheduled by deadline
+    if (!donor || donor == proc || donor->pid == 0 || donor->state != ACTIVE
+        || !proc->on_run_queue || scheduler_class_of(donor) != scheduler_class
+        || scheduler_class_of(proc) != scheduler_class) {
+        return;
+    }
 
-    queue_in(proc->scheduler_queue, proc->pid);
+    remaining = scheduler_class->quantum(donor) - donor->cpu_time;
+    if (remaining <= 0) {
+        return;
+    }
+
+    kernel_log_trace("Handing off from pid=%d to pid=%d", donor->pid, proc->pid);
+
+    // Take the process out of its run queue and make it the active process
+    // If a higher priority process is ready, scheduler_run will still
+    // preempt it
+    donor->switches_voluntary++;
+
+    scheduler_remove(proc);
+    scheduler_add(donor);
+
+    // The process runs for what is left of the donor's time slice
+    proc->cpu_time = scheduler_class->quantum(proc) - remaining;
+    if (proc->cpu_time < 0) {
+        proc->cpu_time = 0;
+    }
+
+    proc->state = ACTIVE;
+    active_proc = proc;
+}
+
+/**
+ * Boosts an interactive process ahead of the other processes in its class
+ * If the process is in a run queue it is moved to the front
+ * @param proc - pointer to the process entry
+ */
+void scheduler_boost(proc_t *proc) {
+    scheduler_class_t *class;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return;
+    }
+
+    class = scheduler_class_of(proc);
+    if (class->boost) {
+        class->boost(proc);
+    }
+}
+
+/**
+ * Sets the scheduling priority of a process
+ * If the process is in a run queue it is moved to the new priority level
+ * @param proc - pointer to the process entry
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int scheduler_set_priority(proc_t *proc, int priority) {
+    int effective = priority;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return -1;
+    }
+
+    if (priority < PROC_PRIORITY_HIGH || priority > PROC_PRIORITY_LOW) {
+        kernel_log_warn("Invalid priority %d for process %d", priority, proc->pid);
+        return -1;
+    }
+
+    // A priority inherited from mutex waiters is kept until the mutex is
+    // unlocked
+    if (proc->priority < proc->base_priority && proc->priority < priority) {
+        effective = proc->priority;
+    }
+
+    proc->base_priority = priority;
+    scheduler_set_effective_priority(proc, effective);
+
+    return 0;
+}
+
+/**
+ * Sets the effective scheduling priority of a process without changing
+ * the priority set for it
+ * If the process is in a run queue it is moved to the new priority level
+ * @param proc - pointer to the process entry
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ */
+void scheduler_set_effective_priority(proc_t *proc, int priority) {
+    int queued;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return;
+    }
+
+    if (proc->priority == priority) {
+        return;
+    }
+
+    // Move the process between run queues if it is waiting to run
+    queued = proc->on_run_queue;
+    if (queued) {
+        scheduler_remove(proc);
+    }
+
+    proc->priority = priority;
+
+    if (queued) {
+        scheduler_add(proc);
+    }
+}
+
+/**
+ * Selects the best-effort scheduling class
+ * Processes that are ready to run are moved to the new class' run queue
+ * @param name - name of the scheduling class
+ * @return 0 on success, -1 if the class does not exist
+ */
+int scheduler_set_class(char *name) {
+    scheduler_class_t *class = NULL;
+    scheduler_class_t *prev = scheduler_class;
+    proc_t *proc;
+    int queued;
+
+    for (int i = 0; scheduler_classes[i]; i++) {
+        if (strcmp(scheduler_classes[i]->name, name) == 0) {
+            class = scheduler_classes[i];
+            break;
+        }
+    }
+
+    if (!class) {
+        kernel_log_warn("Unknown scheduling class %s", name);
+        return -1;
+    }
+
+    if (class == prev) {
+        return 0;
+    }
+
+    kernel_log_info("Selecting scheduling class %s", class->name);
+
+    for (proc = proc_list_first(); proc; proc = proc_list_next(proc)) {
+        if (proc->state == NONE || proc->sched_class) {
+            continue;
+        }
+
+        queued = proc->on_run_queue;
+        if (queued) {
+            prev->dequeue(proc);
+        }
+
+        if (class->attach) {
+            class->attach(proc);
+        }
+
+        if (queued) {
+            class->enqueue(proc);
+        }
+    }
+
+    scheduler_class = class;
+
+    return 0;
+}
+
+/**
+ * Returns the name of the selected best-effort scheduling class
+ * @return name of the scheduling class
+ */
+char *scheduler_get_class(void) {
+    return scheduler_class->name;
 }
 
 /**
@@ -197,13 +669,24 @@ void scheduler_sleep(proc_t *proc, int time) {
 void scheduler_init(void) {
     kernel_log_info("Initializing scheduler");
 
-    /* Initialize the run queue */
-    queue_init(&run_queue);
+    /* Initialize the run queues of every class */
+    if (scheduler_class_rt.init) {
+        scheduler_class_rt.init();
+    }
+
+    for (int i = 0; scheduler_classes[i]; i++) {
+        if (scheduler_classes[i]->init) {
+            scheduler_classes[i]->init();
+        }
+    }
+
+    /* Select the default best-effort class */
+    scheduler_class = scheduler_classes[0];
+    scheduler_set_class(SCHEDULER_CLASS);
 
     /* Initialize the sleep queue */
-    queue_init(&sleep_queue);
+    sleep_queue_size = 0;
 
     /* Register the timer callback */
     timer_callback_register(&scheduler_timer, 1, -1);
 }
-
@@ -0,0 +1,266 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Process Scheduler - Completely Fair Class
+ *
+ * Processes accrue virtual run time inversely proportional to the weight
+ * of their priority; the process that has run the least runs next.
+ */
+
+#include "kernel.h"
+#include "kproc.h"
+#include "scheduler.h"
+#include "scheduler_class.h"
+
+#include "rbtree.h"
+
+// Virtual run time a process accrues per tick at the default priority
+#define CFS_TICK        1024
+
+// Run tree -> ready processes ordered by virtual run time
+rbtree_t run_tree;
+
+// Virtual run time that ready processes are placed relative to
+// Only ever increases (modulo wrapping)
+unsigned int min_vruntime;
+
+// Total weight of the processes in the run tree
+int run_weight;
+
+// Weight of each priority level; each level receives about 1.25 times
+// the CPU time of the level below it
+static const int cfs_weight_table[PROC_PRIORITY_MAX] = {
+    36291, 29154, 23254, 18705, 14949, 11916, 9548, 7620,
+    6100,  4904,  3906,  3121,  2501,  1991,  1586, 1277,
+    1024,  820,   655,   526,   423,   335,   272,  215,
+    172,   137,   110,   87,    70,    56,    45,   36
+};
+
+/**
+ * Returns the scheduling weight of a process
+ * @param proc - pointer to the process entry
+ * @return the weight of the process' priority
+ */
+static int cfs_weight(proc_t *proc) {
+    return cfs_weight_table[proc->priority];
+}
+
+/**
+ * Indicates if a virtual run time is before another one
+ * Compares the difference so the result holds when the value wraps
+ * @param a - first virtual run time
+ * @param b - second virtual run time
+ * @return non-zero if a is before b
+ */
+static int vruntime_before(unsigned int a, unsigned int b) {
+    return (int)(a - b) < 0;
+}
+
+/**
+ * Run tree ordering function
+ * @param a - run tree node of the first process
+ * @param b - run tree node of the second process
+ * @return non-zero if the first process has run less than the second
+ */
+static int run_tree_before(rbtree_node_t *a, rbtree_node_t *b) {
+    return vruntime_before(rbtree_entry(a, proc_t, run_node)->vruntime,
+                           rbtree_entry(b, proc_t, run_node)->vruntime);
+}
+
+/**
+ * Advances the minimum virtual run time to the lowest virtual run time
+ * of the active process and the ready processes
+ */
+static void cfs_update_min_vruntime(void) {
+    rbtree_node_t *node = rbtree_first(&run_tree);
+    unsigned int vruntime = min_vruntime;
+    int found = 0;
+
+    if (active_proc && active_proc->pid != 0 && active_proc->state == ACTIVE
+        && scheduler_class_of(active_proc) == &scheduler_class_cfs) {
+        vruntime = active_proc->vruntime;
+        found = 1;
+    }
+
+    if (node) {
+        proc_t *proc = rbtree_entry(node, proc_t, run_node);
+
+        if (!found || vruntime_before(proc->vruntime, vruntime)) {
+            vruntime = proc->vruntime;
+        }
+        found = 1;
+    }
+
+    if (found && vruntime_before(min_vruntime, vruntime)) {
+        min_vruntime = vruntime;
+    }
+}
+
+/**
+ * Returns the time slice of a process
+ * The scheduling latency is divided among the ready processes by weight
+ * @param proc - pointer to the process entry
+ * @return number of ticks the process may run before being preempted
+ */
+static int cfs_quantum(proc_t *proc) {
+    int total = run_weight;
+    int quantum;
+
+    if (!proc->on_run_queue) {
+        total += cfs_weight(proc);
+    }
+
+    quantum = SCHEDULER_CFS_LATENCY * cfs_weight(proc) / total;
+
+    return (quantum < SCHEDULER_CFS_GRANULARITY) ? SCHEDULER_CFS_GRANULARITY : quantum;
+}
+
+/**
+ * Accounts for a tick of CPU time used by the active process
+ * @param proc - pointer to the process entry
+ */
+static void cfs_tick(proc_t *proc) {
+    if (proc->pid == 0) {
+        return;
+    }
+
+    proc->vruntime += CFS_TICK * 1024 / cfs_weight(proc);
+
+    cfs_update_min_vruntime();
+}
+
+/**
+ * Places a process that becomes ready slightly ahead of the minimum
+ * virtual run time, so a process that has not run for a while does not
+ * run for a burst to catch up
+ * @param proc - pointer to the process entry
+ */
+static void cfs_wake(proc_t *proc) {
+    unsigned int vruntime = min_vruntime - SCHEDULER_CFS_LATENCY * CFS_TICK / 2;
+
+    if (vruntime_before(proc->vruntime, vruntime)) {
+        proc->vruntime = vruntime;
+    }
+}
+
+/**
+ * Starts a process moving into the class at the minimum virtual run time
+ * @param proc - pointer to the process entry
+ */
+static void cfs_attach(proc_t *proc) {
+    proc->vruntime = min_vruntime;
+}
+
+/**
+ * Adds a process that is ready to run to the run tree
+ * @param proc - pointer to the process entry
+ */
+static void cfs_enqueue(proc_t *proc) {
+    if (rbtree_insert(&run_tree, &proc->run_node, run_tree_before) != 0) {
+        kernel_panic("Unable to add the process to the scheduler");
+    }
+
+    run_weight += cfs_weight(proc);
+    proc->on_run_queue = 1;
+}
+
+/**
+ * Removes a process that is ready to run from the run tree
+ * @param proc - pointer to the process entry
+ */
+static void cfs_dequeue(proc_t *proc) {
+    if (rbtree_remove(&run_tree, &proc->run_node) != 0) {
+        kernel_panic("Unable to remove the process from the scheduler");
+    }
+
+    run_weight -= cfs_weight(proc);
+    proc->on_run_queue = 0;
+}
+
+/**
+ * Takes the process that has run the least from the run tree
+ * @return pointer to the process entry, NULL if no process is ready
+ */
+static proc_t *cfs_pick_next(void) {
+    rbtree_node_t *node;
+    proc_t *proc;
+
+    node = rbtree_first(&run_tree);
+    if (!node) {
+        return NULL;
+    }
+
+    proc = rbtree_entry(node, proc_t, run_node);
+    cfs_dequeue(proc);
+    cfs_update_min_vruntime();
+
+    return proc;
+}
+
+/**
+ * Indicates if a ready process should preempt a running process
+ * A process is preempted once a ready process has run less than it by
+ * more than the granularity
+ * @param proc - pointer to the running process entry
+ * @return non-zero if the process should be preempted
+ */
+static int cfs_preempt(proc_t *proc) {
+    rbtree_node_t *node = rbtree_first(&run_tree);
+    unsigned int vruntime;
+
+    if (!node) {
+        return 0;
+    }
+
+    if (proc->pid == 0 || scheduler_class_of(proc) != &scheduler_class_cfs) {
+        return 1;
+    }
+
+    vruntime = rbtree_entry(node, proc_t, run_node)->vruntime;
+
+    return vruntime_before(vruntime + SCHEDULER_CFS_GRANULARITY * CFS_TICK, proc->vruntime);
+}
+
+/**
+ * Moves an interactive process that is ready to run ahead of the
+ * other ready processes
+ * @param proc - pointer to the process entry
+ */
+static void cfs_boost(proc_t *proc) {
+    if (!proc->on_run_queue) {
+        return;
+    }
+
+    cfs_dequeue(proc);
+    proc->vruntime = min_vruntime - SCHEDULER_CFS_LATENCY * CFS_TICK / 2;
+    cfs_enqueue(proc);
+}
+
+/**
+ * Initializes the run tree
+ */
+static void cfs_init(void) {
+    rbtree_init(&run_tree);
+
+    min_vruntime = 0;
+    run_weight = 0;
+}
+
+scheduler_class_t scheduler_class_cfs = {
+    .name      = "cfs",
+    .init      = cfs_init,
+    .attach    = cfs_attach,
+    .enqueue   = cfs_enqueue,
+    .dequeue   = cfs_dequeue,
+    .pick_next = cfs_pick_next,
+    .preempt   = cfs_preempt,
+    .tick      = cfs_tick,
+    .wake      = cfs_wake,
+    .quantum   = cfs_quantum,
+    .release   = NULL,
+    .expire    = NULL,
+    .yield     = NULL,
+    .boost     = cfs_boost,
+};
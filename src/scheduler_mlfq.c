@@ -0,0 +1,321 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Process Scheduler - Multilevel Feedback Queue Class
+ *
+ * Round robin run queues, one per priority level. Processes that use
+ * their whole time slice are demoted to lower levels with longer time
+ * slices and are periodically boosted back to their priority.
+ *
+ * The boost is lazy: the timer only starts a new boost epoch. A process
+ * whose recorded epoch is older is reset when it is enqueued or picked,
+ * and each pick moves at most one process queued before the boost up to
+ * its priority, so no path walks every ready process.
+ */
+
+#include "bit_util.h"
+#include "kernel.h"
+#include "kproc.h"
+#include "scheduler.h"
+#include "scheduler_class.h"
+#include "timer.h"
+
+#include "list.h"
+
+// Process Queues
+list_t run_queue[PROC_PRIORITY_MAX];    // Run queues -> one per priority level
+
+// Ready bitmap -> bit n is set when run_queue[n] contains processes
+unsigned int run_bitmap;
+
+// Incremented by each anti-starvation boost
+int boost_epoch;
+
+// Lowest level that may still hold processes queued before the last
+// boost; 0 once they have all been moved up
+int boost_level;
+
+/**
+ * Returns the run queue level of a process
+ * The level is the process' priority lowered by its feedback level
+ * @param proc - pointer to the process entry
+ * @return the run queue level
+ */
+static int mlfq_level(proc_t *proc) {
+    int level = proc->priority + proc->feedback_level;
+
+    return (level > PROC_PRIORITY_LOW) ? PROC_PRIORITY_LOW : level;
+}
+
+/**
+ * Returns the time slice of a process
+ * Each feedback level doubles the time slice of the one above it
+ * @param proc - pointer to the process entry
+ * @return number of ticks the process may run before being preempted
+ */
+static int mlfq_quantum(proc_t *proc) {
+    return SCHEDULER_TIMESLICE << proc->feedback_level;
+}
+
+/**
+ * Accounts for a process giving up the CPU to sleep or wait
+ * A process that blocks before using its whole time slice moves up a
+ * feedback level
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_release(proc_t *proc) {
+    if (proc->feedback_level > 0 && proc->cpu_time < mlfq_quantum(proc)) {
+        proc->feedback_level--;
+    }
+}
+
+/**
+ * Accounts for a process that used its whole time slice
+ * The process is demoted to the next feedback level, which has a longer
+ * time slice
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_expire(proc_t *proc) {
+    if (proc->feedback_level < SCHEDULER_FEEDBACK_LEVELS - 1) {
+        proc->feedback_level++;
+    }
+}
+
+/**
+ * Resets the feedback level if an anti-starvation boost has occurred
+ * since the process was last scheduled
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_wake(proc_t *proc) {
+    if (proc->boost_epoch != boost_epoch) {
+        proc->feedback_level = 0;
+        proc->boost_epoch = boost_epoch;
+    }
+}
+
+/**
+ * Starts a process moving into the class at the top feedback level
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_attach(proc_t *proc) {
+    proc->feedback_level = 0;
+    proc->boost_epoch = boost_epoch;
+}
+
+/**
+ * Adds a process to the run queue of its level
+ * @param proc - pointer to the process entry
+ * @param front - non-zero to place the process at the front of its run queue
+ */
+static void mlfq_insert(proc_t *proc, int front) {
+    int level = mlfq_level(proc);
+    int rc;
+
+    proc->scheduler_queue = &run_queue[level];
+
+    if (front) {
+        rc = list_prepend(proc->scheduler_queue, &proc->scheduler_node);
+    } else {
+        rc = list_append(proc->scheduler_queue, &proc->scheduler_node);
+    }
+
+    if (rc != 0) {
+        kernel_panic("Unable to add the process to the scheduler");
+    }
+
+    // Mark the priority level as ready
+    run_bitmap |= (1u << level);
+    proc->on_run_queue = 1;
+}
+
+/**
+ * Adds a process that is ready to run to the end of its run queue
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_enqueue(proc_t *proc) {
+    mlfq_wake(proc);
+    mlfq_insert(proc, 0);
+}
+
+/**
+ * Removes a process that is ready to run from its run queue
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_dequeue(proc_t *proc) {
+    int level = proc->scheduler_queue - run_queue;
+
+    // Unlink the process; the rest of the queue order is maintained
+    if (list_remove(proc->scheduler_queue, &proc->scheduler_node) != 0) {
+        kernel_panic("Unable to remove the process from its queue");
+    }
+
+    // Clear the ready bit if the process was the last one at its level
+    if (list_is_empty(proc->scheduler_queue)) {
+        run_bitmap &= ~(1u << level);
+    }
+
+    proc->scheduler_queue = NULL;
+    proc->on_run_queue = 0;
+}
+
+/**
+ * Moves one process queued before the last boost up to its priority
+ * Levels are visited from the lowest, whose processes have waited the
+ * longest; processes queued since the boost follow the ones queued before
+ * it, so only the head of a level is looked at
+ */
+static void mlfq_boost_step(void) {
+    unsigned int mask;
+    proc_t *proc;
+    int level;
+
+    if (boost_level <= 0) {
+        return;
+    }
+
+    // Non-empty levels below the top level, up to the sweep position
+    mask = run_bitmap & ((2u << boost_level) - 1) & ~1u;
+
+    level = bit_last_set(mask);
+    if (level < 0) {
+        boost_level = 0;
+        return;
+    }
+
+    proc = list_entry(run_queue[level].head, proc_t, scheduler_node);
+    if (proc->boost_epoch == boost_epoch) {
+        boost_level = level - 1;
+        return;
+    }
+
+    boost_level = level;
+
+    mlfq_dequeue(proc);
+    mlfq_enqueue(proc);
+}
+
+/**
+ * Takes the next process from the highest priority run queue
+ * @return pointer to the process entry, NULL if no process is ready
+ */
+static proc_t *mlfq_pick_next(void) {
+    int level;
+    list_node_t *node;
+    proc_t *proc;
+
+    mlfq_boost_step();
+
+    level = bit_first_set(run_bitmap);
+    if (level < 0) {
+        return NULL;
+    }
+
+    node = list_pop(&run_queue[level]);
+    if (!node) {
+        kernel_panic("Unable to take a process from run queue %d", level);
+    }
+
+    // Clear the ready bit once the level has been drained
+    if (list_is_empty(&run_queue[level])) {
+        run_bitmap &= ~(1u << level);
+    }
+
+    proc = list_entry(node, proc_t, scheduler_node);
+    proc->scheduler_queue = NULL;
+    proc->on_run_queue = 0;
+
+    // A process queued before the last boost runs at the top feedback level
+    mlfq_wake(proc);
+
+    return proc;
+}
+
+/**
+ * Indicates if a ready process should preempt a running process
+ * A process is preempted when a process at a higher level is ready
+ * @param proc - pointer to the running process entry
+ * @return non-zero if the process should be preempted
+ */
+static int mlfq_preempt(proc_t *proc) {
+    // Highest priority level that has a process ready to run
+    int level = bit_first_set(run_bitmap);
+
+    if (level < 0) {
+        return 0;
+    }
+
+    return proc->pid == 0 || scheduler_class_of(proc) != &scheduler_class_mlfq
+           || level < mlfq_level(proc);
+}
+
+/**
+ * Boosts an interactive process to the top feedback level of its priority
+ * If the process is in a run queue it is moved to the front of the new level
+ * @param proc - pointer to the process entry
+ */
+static void mlfq_boost(proc_t *proc) {
+    proc->feedback_level = 0;
+    proc->boost_epoch = boost_epoch;
+
+    if (!proc->on_run_queue) {
+        return;
+    }
+
+    // Requeue at the front so the process runs ahead of its level
+    mlfq_dequeue(proc);
+    mlfq_insert(proc, 1);
+}
+
+/**
+ * Anti-starvation timer callback
+ * Starts a boost epoch; every process is lifted back to the top feedback
+ * level of its priority as it is enqueued, picked or reached by the sweep
+ */
+static void mlfq_boost_timer(void) {
+    if (scheduler_class != &scheduler_class_mlfq) {
+        return;
+    }
+
+    boost_epoch++;
+    boost_level = PROC_PRIORITY_LOW;
+
+    if (active_proc) {
+        active_proc->feedback_level = 0;
+        active_proc->boost_epoch = boost_epoch;
+    }
+}
+
+/**
+ * Initializes the run queues
+ */
+static void mlfq_init(void) {
+    for (int i = 0; i < PROC_PRIORITY_MAX; i++) {
+        list_init(&run_queue[i]);
+    }
+
+    run_bitmap = 0;
+    boost_epoch = 0;
+    boost_level = 0;
+
+    // Register the anti-starvation boost
+    timer_callback_register(&mlfq_boost_timer, SCHEDULER_BOOST_INTERVAL, -1);
+}
+
+scheduler_class_t scheduler_class_mlfq = {
+    .name      = "mlfq",
+    .init      = mlfq_init,
+    .attach    = mlfq_attach,
+    .enqueue   = mlfq_enqueue,
+    .dequeue   = mlfq_dequeue,
+    .pick_next = mlfq_pick_next,
+    .preempt   = mlfq_preempt,
+    .tick      = NULL,
+    .wake      = mlfq_wake,
+    .quantum   = mlfq_quantum,
+    .release   = mlfq_release,
+    .expire    = mlfq_expire,
+    .yield     = NULL,
+    .boost     = mlfq_boost,
+};
@@ -0,0 +1,272 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * Kernel Process Scheduler - Real-Time Class
+ *
+ * Periodic processes scheduled earliest deadline first. Each period a
+ * job is released that must complete (by yielding) before the next
+ * release, using no more than its budget of CPU time.
+ */
+
+#include "kernel.h"
+#include "kproc.h"
+#include "scheduler.h"
+#include "scheduler_class.h"
+#include "timer.h"
+
+#include "rbtree.h"
+
+// Real-time run tree -> ready periodic processes ordered by deadline
+rbtree_t rt_tree;
+
+// Total utilization of the periodic processes, in tenths of a percent
+int rt_utilization;
+
+/**
+ * Run tree ordering function for periodic processes
+ * @param a - run tree node of the first process
+ * @param b - run tree node of the second process
+ * @return non-zero if the first process has the earlier deadline
+ */
+static int rt_tree_before(rbtree_node_t *a, rbtree_node_t *b) {
+    return (rbtree_entry(a, proc_t, run_node)->deadline
+            - rbtree_entry(b, proc_t, run_node)->deadline) < 0;
+}
+
+/**
+ * Returns the utilization of a periodic process, rounded up
+ * @param period - number of ticks between job releases
+ * @param budget - number of ticks of CPU time each job may use
+ * @return utilization in tenths of a percent
+ */
+static int rt_utilization_of(int period, int budget) {
+    return (budget * 1000 + period - 1) / period;
+}
+
+/**
+ * Adds a periodic process that is ready to run to the run tree
+ * @param proc - pointer to the process entry
+ */
+static void rt_enqueue(proc_t *proc) {
+    if (rbtree_insert(&rt_tree, &proc->run_node, rt_tree_before) != 0) {
+        kernel_panic("Unable to add the process to the scheduler");
+    }
+
+    proc->on_run_queue = 1;
+}
+
+/**
+ * Removes a periodic process from the run tree
+ * @param proc - pointer to the process entry
+ */
+static void rt_dequeue(proc_t *proc) {
+    if (rbtree_remove(&rt_tree, &proc->run_node) != 0) {
+        kernel_panic("Unable to remove the process from the scheduler");
+    }
+
+    proc->on_run_queue = 0;
+}
+
+/**
+ * Takes the periodic process with the earliest deadline from the run tree
+ * @return pointer to the process entry, NULL if no periodic process is ready
+ */
+static proc_t *rt_pick_next(void) {
+    rbtree_node_t *node = rbtree_first(&rt_tree);
+    proc_t *proc;
+
+    if (!node) {
+        return NULL;
+    }
+
+    proc = rbtree_entry(node, proc_t, run_node);
+    rt_dequeue(proc);
+
+    return proc;
+}
+
+/**
+ * Indicates if a ready periodic process should preempt a running process
+ * Periodic processes preempt all other processes and those with a later
+ * deadline
+ * @param proc - pointer to the running process entry
+ * @return non-zero if the process should be preempted
+ */
+static int rt_preempt(proc_t *proc) {
+    rbtree_node_t *node = rbtree_first(&rt_tree);
+
+    if (!node) {
+        return 0;
+    }
+
+    if (scheduler_class_of(proc) != &scheduler_class_rt) {
+        return 1;
+    }
+
+    return (rbtree_entry(node, proc_t, run_node)->deadline - proc->deadline) < 0;
+}
+
+/**
+ * Periodic processes run until their job completes or is preempted by
+ * one with an earlier deadline
+ * @param proc - pointer to the process entry
+ * @return 0; periodic processes have no time slice
+ */
+static int rt_quantum(proc_t *proc) {
+    (void)proc;
+
+    return 0;
+}
+
+/**
+ * Ends the current job of a periodic process
+ * The next job is released at the end of the current period; the process
+ * sleeps until then. A process that has fallen more than a period behind
+ * starts a new period immediately.
+ * @param proc - pointer to the process entry
+ */
+static void rt_yield(proc_t *proc) {
+    int now = timer_get_ticks();
+
+    if ((now - proc->deadline) >= 0) {
+        proc->deadline_misses++;
+        kernel_log_trace("Process pid=%d missed its deadline by %d ticks", proc->pid, now - proc->deadline);
+    }
+
+    // Release the next job
+    proc->release_time = proc->deadline;
+    if ((now - proc->release_time) >= proc->period) {
+        proc->release_time = now;
+    }
+
+    proc->deadline = proc->release_time + proc->period;
+    proc->budget_used = 0;
+
+    scheduler_suspend(proc, proc->release_time);
+}
+
+/**
+ * Accounts for a tick of CPU time used by a periodic process
+ * A job that exceeds its budget is stopped until its next release
+ * Budgets are charged in whole ticks so a job is allowed to run into
+ * one more tick than its budget
+ * @param proc - pointer to the process entry
+ */
+static void rt_tick(proc_t *proc) {
+    if (++proc->budget_used <= proc->budget) {
+        return;
+    }
+
+    proc->budget_overruns++;
+    proc->switches_involuntary++;
+
+    kernel_log_trace("Process pid=%d exceeded its budget", proc->pid);
+
+    rt_yield(proc);
+}
+
+/**
+ * Initializes the run tree
+ */
+static void rt_init(void) {
+    rbtree_init(&rt_tree);
+    rt_utilization = 0;
+}
+
+scheduler_class_t scheduler_class_rt = {
+    .name      = "rt",
+    .init      = rt_init,
+    .attach    = NULL,
+    .enqueue   = rt_enqueue,
+    .dequeue   = rt_dequeue,
+    .pick_next = rt_pick_next,
+    .preempt   = rt_preempt,
+    .tick      = rt_tick,
+    .wake      = NULL,
+    .quantum   = rt_quantum,
+    .release   = NULL,
+    .expire    = NULL,
+    .yield     = rt_yield,
+    .boost     = NULL,
+};
+
+/**
+ * Makes a process periodic, or a regular process again
+ * Periodic processes run ahead of all other processes, earliest deadline
+ * first. Each period a job is released that must complete (by yielding)
+ * before the next release, using no more than its budget of CPU time.
+ * A process is only admitted if the total utilization of the periodic
+ * processes stays within SCHEDULER_RT_UTILIZATION
+ * @param proc - pointer to the process entry
+ * @param period - number of ticks between job releases, 0 to clear
+ * @param budget - number of ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int scheduler_set_periodic(proc_t *proc, int period, int budget) {
+    int utilization = 0;
+    int queued;
+
+    if (!proc) {
+        kernel_panic("Invalid process");
+        return -1;
+    }
+
+    if (period < 0 || (period > 0 && (budget <= 0 || budget > period)) || proc->pid == 0) {
+        kernel_log_warn("Invalid period %d / budget %d for process %d", period, budget, proc->pid);
+        return -1;
+    }
+
+    // Admission control; the new reservation replaces any existing one
+    if (period > 0) {
+        utilization = rt_utilization_of(period, budget);
+    }
+
+    if (proc->period) {
+        rt_utilization -= rt_utilization_of(proc->period, proc->budget);
+    }
+
+    if (rt_utilization + utilization > SCHEDULER_RT_UTILIZATION) {
+        kernel_log_warn("Unable to admit process %d; utilization would be %d/1000",
+                        proc->pid, rt_utilization + utilization);
+
+        if (proc->period) {
+            rt_utilization += rt_utilization_of(proc->period, proc->budget);
+        }
+
+        return -1;
+    }
+
+    rt_utilization += utilization;
+
+    // Move the process between scheduling classes if it is waiting to run
+    queued = proc->on_run_queue;
+    if (queued) {
+        scheduler_remove(proc);
+    }
+
+    // The first job is released immediately
+    proc->period = period;
+    proc->budget = budget;
+    proc->budget_used = 0;
+    proc->release_time = timer_get_ticks();
+    proc->deadline = proc->release_time + period;
+    proc->cpu_time = 0;
+
+    if (period > 0) {
+        proc->sched_class = &scheduler_class_rt;
+    } else if (proc->sched_class == &scheduler_class_rt) {
+        proc->sched_class = NULL;
+
+        if (scheduler_class->attach) {
+            scheduler_class->attach(proc);
+        }
+    }
+
+    if (queued) {
+        scheduler_add(proc);
+    }
+
+    return 0;
+}
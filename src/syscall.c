@@ -116,6 +116,14 @@ void proc_sleep(int secs) {
     _syscall1(SYSCALL_PROC_SLEEP, secs);
 }
 
+/**
+ * Yields the CPU to other processes that are ready to run
+ * The current process is placed at the end of its run queue
+ */
+void proc_yield(void) {
+    _syscall0(SYSCALL_PROC_YIELD);
+}
+
 /**
  * Exits the current process
  * @param exitcode An exit code to return to the parent process
@@ -142,14 +150,82 @@ int proc_get_name(char *name) {
 }
 
 /**
- * Writes up to n bytes to the process' specified IO buffer
- * @param io - the IO buffer to write to
+ * Sets the current process' scheduling priority
+ * @param priority - priority level (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int proc_set_priority(int priority) {
+    return _syscall1(SYSCALL_PROC_SET_PRIORITY, priority);
+}
+
+/**
+ * Gets the current process' scheduling priority
+ * @return priority level or -1 on error
+ */
+int proc_get_priority(void) {
+    return _syscall0(SYSCALL_PROC_GET_PRIORITY);
+}
+
+/**
+ * Makes the current process periodic; each job must complete by calling
+ * proc_yield within its budget before the end of its period
+ * @param period - number of timer ticks between job releases, 0 to clear
+ * @param budget - number of timer ticks of CPU time each job may use
+ * @return 0 on success, -1 on error or if the process can not be admitted
+ */
+int proc_set_periodic(int period, int budget) {
+    return _syscall2(SYSCALL_PROC_SET_PERIODIC, period, budget);
+}
+
+/**
+ * Creates a new process
+ * @param entry - function the process starts executing
+ * @param name - process name
+ * @param flags - PROC_SPAWN_TTY to attach the process to the current process' TTY
+ * @return process id of the new process, -1 on error
+ */
+int proc_spawn(void (*entry)(void), char *name, int flags) {
+    return _syscall3(SYSCALL_PROC_SPAWN, (int)entry, (int)name, flags);
+}
+
+/**
+ * Creates a copy of the current process
+ * Both processes continue from the return of this call
+ * @return process id of the copy in the current process, 0 in the copy, -1 on error
+ */
+int proc_fork(void) {
+    return _syscall0(SYSCALL_PROC_FORK);
+}
+
+/**
+ * Writes n bytes to the process' specified IO buffer
+ * Blocks until all of the bytes are copied; with PROC_IO_SHORT set in io,
+ * returns once some are copied, and with PROC_IO_NONBLOCK set, copies only
+ * what fits without blocking
+ * @param io - the IO buffer to write to, optionally with IO flags
  * @param buf - the buffer to copy from
  * @param n - number of bytes to write
  * @return -1 on error or value indicating number of bytes copied
  */
 int io_write(int io, char *buf, int n) {
-    return _syscall3(SYSCALL_IO_WRITE, io, (int)buf, n);
+    int count = 0;
+    int rc;
+
+    if (io & (PROC_IO_SHORT | PROC_IO_NONBLOCK)) {
+        return _syscall3(SYSCALL_IO_WRITE, io, (int)buf, n);
+    }
+
+    // Each system call copies what fits, blocking while the buffer is full
+    while (count < n) {
+        rc = _syscall3(SYSCALL_IO_WRITE, io, (int)(buf + count), n - count);
+        if (rc <= 0) {
+            return count ? count : rc;
+        }
+
+        count += rc;
+    }
+
+    return count;
 }
 
 /**
@@ -243,3 +319,95 @@ int sem_post(int sem) {
     return _syscall1(SYSCALL_SEM_POST, sem);
 }
 
+/**
+ * Creates a shared memory region and attaches the current process to it
+ * The region starts out clear and is released when the last process
+ * detaches from it (or exits)
+ * @param size - size of the region in bytes
+ * @return -1 on error, otherwise the shared memory id
+ */
+int shm_create(int size) {
+    return _syscall1(SYSCALL_SHM_CREATE, size);
+}
+
+/**
+ * Attaches the current process to a shared memory region
+ * @param shm - shared memory id
+ * @return address of the region, NULL on error
+ */
+void *shm_attach(int shm) {
+    return (void *)_syscall1(SYSCALL_SHM_ATTACH, shm);
+}
+
+/**
+ * Detaches the current process from a shared memory region
+ * @param shm - shared memory id
+ * @return -1 on error, 0 on success
+ */
+int shm_detach(int shm) {
+    return _syscall1(SYSCALL_SHM_DETACH, shm);
+}
+
+/**
+ * Blocks the current process until the futex is woken, if the futex word
+ * still holds the expected value
+ * @param addr - address of the futex word
+ * @param val - value the caller last saw in the futex word
+ * @return 0 once woken, -1 if the value changed or on error
+ */
+int futex_wait(volatile int *addr, int val) {
+    return _syscall2(SYSCALL_FUTEX_WAIT, (int)addr, val);
+}
+
+/**
+ * Wakes processes waiting on a futex
+ * @param addr - address of the futex word
+ * @param count - maximum number of processes to wake
+ * @return number of processes woken, -1 on error
+ */
+int futex_wake(volatile int *addr, int count) {
+    return _syscall2(SYSCALL_FUTEX_WAKE, (int)addr, count);
+}
+
+/**
+ * Locks a priority inheritance futex that is held by another process
+ * The owner runs at the current process' priority until the futex is
+ * passed to the current process
+ * @param addr - address of the futex word
+ * @return 0 once the current process owns the futex, -1 on error
+ */
+int futex_lock(volatile int *addr) {
+    return _syscall1(SYSCALL_FUTEX_LOCK, (int)addr);
+}
+
+/**
+ * Unlocks a priority inheritance futex that processes are blocked on
+ * The futex is passed to the highest priority process waiting on it
+ * @param addr - address of the futex word
+ * @return 0 on success, -1 if the current process does not own the futex
+ */
+int futex_unlock(volatile int *addr) {
+    return _syscall1(SYSCALL_FUTEX_UNLOCK, (int)addr);
+}
+
+/**
+ * Creates a pipe and binds its ends into free IO slots of the current process
+ * Reads of an empty pipe return 0 once every write end is closed; writes
+ * fail once every read end is closed
+ * @param ends - where the IO ids of the read and write ends are stored
+ * @param size - capacity of the pipe in bytes; 0 for the largest capacity
+ * @return -1 on error, 0 on success
+ */
+int pipe(int *ends, int size) {
+    return _syscall2(SYSCALL_PIPE, (int)ends, size);
+}
+
+/**
+ * Closes an IO slot of the current process
+ * A pipe is released when the last IO slot referring to it is closed
+ * @param io - the IO id
+ * @return -1 on error, 0 on success
+ */
+int io_close(int io) {
+    return _syscall1(SYSCALL_IO_CLOSE, io);
+}
@@ -9,6 +9,7 @@
 #include <spede/string.h>
 
 #include "kernel.h"
+#include "scheduler.h"
 #include "timer.h"
 #include "tty.h"
 #include "vga.h"
@@ -55,8 +56,89 @@ struct tty_t *tty_get(int tty) {
     return &tty_table[tty];
 }
 
+/**
+ * Updates a TTY's screen buffer with the given character
+ * @param tty - pointer to the TTY
+ * @param c - character to update on the TTY screen output
+ */
+static void tty_put(struct tty_t *tty, char c) {
+//    kernel_log_debug("tty[%d]: input char=%c", tty->id, c);
+//    kernel_log_debug("  before scroll=%d, x=%d, y=%d", tty->pos_scroll, tty->pos_x, tty->pos_y);
+
+    switch (c) {
+        case '\t':
+            tty->pos_x += 4 - tty->pos_x % 4;
+            break;
+
+        case '\b':
+            if (tty->pos_x != 0) {
+                tty->pos_x--;
+            } else if (tty->pos_y != 0) {
+                tty->pos_y--;
+                tty->pos_x = TTY_WIDTH - 1;
+            }
+            break;
+
+        case '\r':
+            tty->pos_x = 0;
+            break;
+
+        case '\n':
+            tty->pos_y++;
+            tty->pos_x = 0;
+            break;
+
+        default:
+            tty->buf[(tty->pos_scroll * TTY_WIDTH) + (tty->pos_x + tty->pos_y * TTY_WIDTH)] = c;
+            tty->pos_x++;
+            break;
+    }
+
+    if (tty->pos_y >= TTY_HEIGHT) {
+        int x;
+        int y;
+
+        for (x = 0; x < TTY_WIDTH; x++) {
+            for (y = 1; y < TTY_HEIGHT; y++) {
+                tty->buf[TTY_WIDTH * (y - 1) + x] = tty->buf[TTY_WIDTH * y + x];
+            }
+        }
+
+        for (x = 0; x < TTY_WIDTH; x++) {
+            tty->buf[TTY_WIDTH * (y - 1) + x] = ' ';
+        }
+
+        tty->pos_y = TTY_HEIGHT - 1;
+    }
+
+//    kernel_log_debug("  after: scroll=%d, x=%d, y=%d", tty->pos_scroll, tty->pos_x, tty->pos_y);
+    tty->refresh = 1;
+}
+
+/**
+ * Moves a TTY's pending output into its screen buffer
+ * Writers blocked on the full output buffer are woken up
+ * @param tty - pointer to the TTY
+ */
+static void tty_drain(struct tty_t *tty) {
+    char c;
+
+    if (ringbuf_is_empty(tty->io_output)) {
+        return;
+    }
+
+    while (ringbuf_read(tty->io_output, &c) == 0) {
+        tty_put(tty, c);
+    }
+
+    // Writers blocked on the full buffer retry their writes
+    while (scheduler_wake(&tty->io_output->writers));
+}
+
 /**
  * Refreshes the tty if needed
+ * The output of every TTY is drained into its screen buffer, so processes
+ * writing to TTYs that are not displayed are not blocked
  */
 void tty_refresh(void) {
     if (!active_tty) {
@@ -64,16 +146,15 @@ void tty_refresh(void) {
         return;
     }
 
-    struct tty_t *tty = active_tty;
-    char c;
+    struct tty_t *tty;
 
     // Handle new I/O
-    while (!ringbuf_is_empty(&tty->io_output)) {
-        if (ringbuf_read(&tty->io_output, &c) == 0) {
-            tty_update(c);
-        }
+    for (int i = 0; i < TTY_MAX; i++) {
+        tty_drain(&tty_table[i]);
     }
 
+    tty = active_tty;
+
     if (tty->refresh) {
         kernel_log_trace("tty[%d]: refreshing", tty->id);
 
@@ -101,14 +182,29 @@ void tty_refresh(void) {
  * @param c - character to write into the input buffer
  */
 void tty_input(char c) {
+    proc_t *proc;
+
     if (!active_tty) {
         return;
     }
 
-    ringbuf_write(&active_tty->io_input, c);
+    ringbuf_write(active_tty->io_input, c);
 
+    // The keyboard handler can not wait for the output to be drained, so
+    // a full output buffer is drained here rather than losing the echo
     if (active_tty->echo) {
-        ringbuf_write(&active_tty->io_output, c);
+        if (ringbuf_is_full(active_tty->io_output)) {
+            tty_drain(active_tty);
+        }
+
+        ringbuf_write(active_tty->io_output, c);
+    }
+
+    // Wake the processes blocked reading from the TTY and boost them so
+    // the keystroke is handled ahead of processes that are using up their
+    // time slices
+    while ((proc = scheduler_wake(&active_tty->io_input->readers))) {
+        scheduler_boost(proc);
     }
 }
 
@@ -121,59 +217,7 @@ void tty_update(char c) {
         return;
     }
 
-    struct tty_t *tty = active_tty;
-
-//    kernel_log_debug("tty[%d]: input char=%c", tty->id, c);
-//    kernel_log_debug("  before scroll=%d, x=%d, y=%d", tty->pos_scroll, tty->pos_x, tty->pos_y);
-
-    switch (c) {
-        case '\t':
-            tty->pos_x += 4 - tty->pos_x % 4;
-            break;
-
-        case '\b':
-            if (tty->pos_x != 0) {
-                tty->pos_x--;
-            } else if (tty->pos_y != 0) {
-                tty->pos_y--;
-                tty->pos_x = TTY_WIDTH - 1;
-            }
-            break;
-
-        case '\r':
-            tty->pos_x = 0;
-            break;
-
-        case '\n':
-            tty->pos_y++;
-            tty->pos_x = 0;
-            break;
-
-        default:
-            tty->buf[(tty->pos_scroll * TTY_WIDTH) + (tty->pos_x + tty->pos_y * TTY_WIDTH)] = c;
-            tty->pos_x++;
-            break;
-    }
-
-    if (tty->pos_y >= TTY_HEIGHT) {
-        int x;
-        int y;
-
-        for (x = 0; x < TTY_WIDTH; x++) {
-            for (y = 1; y < TTY_HEIGHT; y++) {
-                tty->buf[TTY_WIDTH * (y - 1) + x] = tty->buf[TTY_WIDTH * y + x];
-            }
-        }
-
-        for (x = 0; x < TTY_WIDTH; x++) {
-            tty->buf[TTY_WIDTH * (y - 1) + x] = ' ';
-        }
-
-        tty->pos_y = TTY_HEIGHT - 1;
-    }
-
-//    kernel_log_debug("  after: scroll=%d, x=%d, y=%d", tty->pos_scroll, tty->pos_x, tty->pos_y);
-    tty->refresh = 1;
+    tty_put(active_tty, c);
 }
 
 /**
@@ -190,6 +234,13 @@ void tty_init(void) {
         tty_table[i].color_bg = VGA_COLOR_BLACK;
         tty_table[i].color_fg = VGA_COLOR_LIGHT_GREY;
         tty_table[i].echo = 0;
+
+        tty_table[i].io_input = ringbuf_alloc();
+        tty_table[i].io_output = ringbuf_alloc();
+
+        if (!tty_table[i].io_input || !tty_table[i].io_output) {
+            kernel_panic("tty[%d]: unable to allocate I/O buffers", i);
+        }
     }
 
     // Select tty 0 to start with
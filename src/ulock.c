@@ -0,0 +1,118 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2022
+ *
+ * User space locks
+ *
+ * The lock state is updated with atomic instructions, so taking or
+ * releasing an uncontended lock does not enter the kernel. Contended
+ * locks block and wake through the futex system calls; mutexes use the
+ * priority inheritance futexes, which need the owner's process id in the
+ * mutex, so the caller passes its own.
+ */
+
+#include "syscall.h"
+#include "ulock.h"
+
+/**
+ * Atomically replaces a value if it holds the expected one
+ * @param addr - address of the value
+ * @param expected - value expected at the address
+ * @param value - value to store
+ * @return the value that was at the address
+ */
+static inline int ulock_cmpxchg(volatile int *addr, int expected, int value) {
+    int prev;
+
+    asm volatile("lock cmpxchgl %2, %1"
+                 : "=a"(prev), "+m"(*addr)
+                 : "r"(value), "0"(expected)
+                 : "memory");
+
+    return prev;
+}
+
+/**
+ * Atomically adds to a value
+ * @param addr - address of the value
+ * @param value - amount to add
+ * @return the value that was at the address
+ */
+static inline int ulock_xadd(volatile int *addr, int value) {
+    asm volatile("lock xaddl %0, %1" : "+r"(value), "+m"(*addr) : : "memory");
+
+    return value;
+}
+
+/**
+ * Locks the mutex
+ * @param mutex - pointer to the mutex
+ * @param pid - process id of the current process
+ * @note If the mutex is already locked, the process blocks and the owner
+ *       runs at the process' priority until the mutex is passed on
+ */
+void umutex_lock(umutex_t *mutex, int pid) {
+    if (ulock_cmpxchg(&mutex->owner, 0, pid) == 0) {
+        return;
+    }
+
+    // The kernel marks the mutex as having waiters, so the unlock enters
+    // the kernel, and blocks until the mutex is passed to this process
+    futex_lock(&mutex->owner);
+}
+
+/**
+ * Unlocks the mutex
+ * @param mutex - pointer to the mutex
+ * @param pid - process id of the current process
+ */
+void umutex_unlock(umutex_t *mutex, int pid) {
+    if (ulock_cmpxchg(&mutex->owner, pid, 0) == pid) {
+        return;
+    }
+
+    // Processes are waiting; the kernel passes the mutex to the highest
+    // priority one
+    futex_unlock(&mutex->owner);
+}
+
+/**
+ * Waits on the semaphore
+ * @param sem - pointer to the semaphore
+ * @note If the semaphore count is 0, the process blocks
+ */
+void usem_wait(usem_t *sem) {
+    int count;
+
+    while (1) {
+        count = sem->count;
+        if (count > 0 && ulock_cmpxchg(&sem->count, count, count - 1) == count) {
+            return;
+        }
+
+        if (count > 0) {
+            continue;
+        }
+
+        // Register as a waiter before the final check of the count, so a
+        // post either sees the waiter or the count is seen here
+        ulock_xadd(&sem->waiters, 1);
+        if (sem->count == 0) {
+            futex_wait(&sem->count, 0);
+        }
+        ulock_xadd(&sem->waiters, -1);
+    }
+}
+
+/**
+ * Posts the semaphore
+ * @param sem - pointer to the semaphore
+ */
+void usem_post(usem_t *sem) {
+    ulock_xadd(&sem->count, 1);
+
+    if (sem->waiters > 0) {
+        futex_wake(&sem->count, 1);
+    }
+}